@@ -0,0 +1,12 @@
+#ifndef ALLOCCOUNTER_H
+#define ALLOCCOUNTER_H
+
+#include <cstddef>
+
+// Linking alloccounter.cpp replaces the global operator new with one that
+// counts every heap allocation made by the program.
+namespace AllocCounter {
+    std::size_t count();
+}
+
+#endif // ALLOCCOUNTER_H
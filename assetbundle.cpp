@@ -0,0 +1,109 @@
+#include "assetbundle.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+AssetBundle::~AssetBundle() {
+    close();
+}
+
+bool AssetBundle::open(const char* path) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+    fileHandle = file;
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+    mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+    base = static_cast<const std::uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    mappedSize = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    const int fd = ::open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapped == MAP_FAILED) return false;
+    base = static_cast<const std::uint8_t*>(mapped);
+    mappedSize = static_cast<std::size_t>(info.st_size);
+#endif
+    if (!base || !validate()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool AssetBundle::validate() {
+    if (mappedSize < sizeof(Bundle::Header)) return false;
+    Bundle::Header header;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, Bundle::MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != Bundle::VERSION) return false;
+    if (header.entryCount > (mappedSize - sizeof(header)) / sizeof(Bundle::Entry)) return false;
+
+    entries = reinterpret_cast<const Bundle::Entry*>(base + sizeof(header));
+    entryCount = header.entryCount;
+    for (std::uint32_t i = 0; i < entryCount; i++) {
+        const Bundle::Entry& entry = entries[i];
+        if (entry.offset % Bundle::ALIGNMENT != 0 || entry.offset > mappedSize ||
+            entry.size > mappedSize - entry.offset) return false;
+        if (entry.type == static_cast<std::uint32_t>(Bundle::EntryType::IMAGE) &&
+            static_cast<std::uint64_t>(entry.pitch) * entry.height > entry.size) return false;
+    }
+    return true;
+}
+
+void AssetBundle::close() {
+#ifdef _WIN32
+    if (base) UnmapViewOfFile(base);
+    if (mappingHandle) CloseHandle(mappingHandle);
+    if (fileHandle) CloseHandle(fileHandle);
+    mappingHandle = nullptr;
+    fileHandle = nullptr;
+#else
+    if (base) munmap(const_cast<std::uint8_t*>(base), mappedSize);
+#endif
+    base = nullptr;
+    mappedSize = 0;
+    entries = nullptr;
+    entryCount = 0;
+}
+
+bool AssetBundle::isOpen() const {
+    return base != nullptr;
+}
+
+const Bundle::Entry* AssetBundle::find(Bundle::EntryType type, std::uint32_t id) const {
+    for (std::uint32_t i = 0; i < entryCount; i++)
+        if (entries[i].type == static_cast<std::uint32_t>(type) && entries[i].id == id) return &entries[i];
+    return nullptr;
+}
+
+const std::uint8_t* AssetBundle::data(const Bundle::Entry& entry) const {
+    return base + entry.offset;
+}
+
+std::uint32_t AssetBundle::size() const {
+    return entryCount;
+}
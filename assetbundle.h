@@ -0,0 +1,73 @@
+#ifndef ASSETBUNDLE_H
+#define ASSETBUNDLE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Layout of a packed asset bundle, written by bundlepacker and memory-mapped
+// by the game. All fields are little-endian; payloads start on ALIGNMENT bytes.
+namespace Bundle {
+    constexpr char MAGIC[4] = {'F', 'B', 'P', 'K'};
+    constexpr std::uint32_t VERSION = 1;
+    constexpr std::uint64_t ALIGNMENT = 16;
+
+    enum class EntryType : std::uint32_t {
+        IMAGE,  // Ảnh ARGB8888 đã thu nhỏ/quay sẵn, sẵn sàng đưa vào atlas
+        SOUND,  // PCM đúng định dạng đầu ra của mixer
+        MUSIC,  // Nguyên file nhạc, mixer tự giải mã khi phát
+        FONT    // Nguyên file font TTF
+    };
+
+    struct Header {
+        char magic[4];              // "FBPK"
+        std::uint32_t version;      // VERSION
+        std::uint32_t entryCount;   // Số entry ngay sau header
+        std::uint32_t reserved;
+    };
+
+    struct Entry {
+        std::uint32_t type;     // EntryType
+        std::uint32_t id;       // Giá trị Sprite/Sound/Music, 0 với font
+        std::uint64_t offset;   // Vị trí dữ liệu tính từ đầu file
+        std::uint64_t size;     // Số byte dữ liệu
+        std::uint32_t width;    // Ảnh: chiều rộng; âm thanh: tần số
+        std::uint32_t height;   // Ảnh: chiều cao; âm thanh: số kênh
+        std::uint32_t pitch;    // Ảnh: số byte mỗi dòng; âm thanh: định dạng mẫu SDL
+        std::uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 16 && sizeof(Entry) == 40, "bundle structs must not be padded");
+}
+
+// Read-only memory mapping of a bundle file. Pointers into it stay valid
+// until close(), so anything built on top must be freed first.
+class AssetBundle {
+private:
+    const std::uint8_t* base = nullptr;
+    std::size_t mappedSize = 0;
+    const Bundle::Entry* entries = nullptr;
+    std::uint32_t entryCount = 0;
+#ifdef _WIN32
+    void* fileHandle = nullptr;
+    void* mappingHandle = nullptr;
+#endif
+
+    bool validate();
+
+public:
+    AssetBundle() = default;
+    ~AssetBundle();
+    AssetBundle(const AssetBundle&) = delete;
+    AssetBundle& operator=(const AssetBundle&) = delete;
+
+    bool open(const char* path);
+    void close();
+    bool isOpen() const;
+
+    // Returns nullptr when the bundle has no such entry.
+    const Bundle::Entry* find(Bundle::EntryType type, std::uint32_t id) const;
+    const std::uint8_t* data(const Bundle::Entry& entry) const;
+    std::uint32_t size() const;
+};
+
+#endif // ASSETBUNDLE_H
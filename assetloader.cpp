@@ -0,0 +1,117 @@
+#include "assetloader.h"
+#include <algorithm>
+#include <thread>
+#include "assets.h"
+
+namespace {
+
+double millisecondsSince(Uint64 start) {
+    return static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+int loaderThreads() {
+    const int hardware = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(hardware, 2, 8);
+}
+
+template <typename T>
+std::future<T> readyFuture(T value) {
+    std::promise<T> promise;
+    promise.set_value(value);
+    return promise.get_future();
+}
+
+// The bundle is mapped read-only; SDL only reads through these pointers.
+void* mapped(const std::uint8_t* data) {
+    return const_cast<std::uint8_t*>(data);
+}
+
+}
+
+AssetLoader::AssetLoader() : pool(loaderThreads()), startCounter(SDL_GetPerformanceCounter()) {}
+
+bool AssetLoader::openBundle(const char* path) {
+    if (!bundle.open(path)) {
+        SDL_Log("No usable asset bundle at %s, loading loose files", path);
+        return false;
+    }
+    SDL_Log("Mapped %s with %u entries", path, static_cast<unsigned>(bundle.size()));
+    return true;
+}
+
+std::future<SDL_Surface*> AssetLoader::loadSprite(Sprite sprite) {
+    const Bundle::Entry* entry = bundle.find(Bundle::EntryType::IMAGE, static_cast<std::uint32_t>(sprite));
+    if (entry) {
+        return readyFuture(SDL_CreateRGBSurfaceWithFormatFrom(mapped(bundle.data(*entry)),
+            static_cast<int>(entry->width), static_cast<int>(entry->height), 32,
+            static_cast<int>(entry->pitch), SDL_PIXELFORMAT_ARGB8888));
+    }
+    const SpriteSource& source = Assets::SPRITES[static_cast<int>(sprite)];
+    return pool.async([source] {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        SDL_Surface* surface = SpriteAtlas::decode(source);
+        SDL_Log("Decoded %s%s in %.2f ms", source.file, source.rotated ? " (rotated)" : "", millisecondsSince(start));
+        return surface;
+    });
+}
+
+bool AssetLoader::loadCollisionMasks(CollisionMasks& masks) {
+    const Sprite sprites[] = {Sprite::PIPE, Sprite::PIPE_FLIPPED, Sprite::PLAYER1, Sprite::PLAYER2};
+    std::future<SDL_Surface*> pending[SDL_arraysize(sprites)];
+    for (size_t i = 0; i < SDL_arraysize(sprites); i++) pending[i] = loadSprite(sprites[i]);
+    SDL_Surface* surfaces[static_cast<int>(Sprite::COUNT)] = {};
+    for (size_t i = 0; i < SDL_arraysize(sprites); i++) surfaces[static_cast<int>(sprites[i])] = pending[i].get();
+    const bool built = SpriteAtlas::collisionMasks(surfaces, masks);
+    for (SDL_Surface* surface : surfaces) SDL_FreeSurface(surface);
+    return built;
+}
+
+std::future<Mix_Chunk*> AssetLoader::loadChunk(Sound sound) {
+    const Bundle::Entry* entry = bundle.find(Bundle::EntryType::SOUND, static_cast<std::uint32_t>(sound));
+    int frequency = 0, channels = 0;
+    Uint16 format = 0;
+    // Raw chunks are played as-is, so they must already match the mixer output.
+    if (entry && Mix_QuerySpec(&frequency, &format, &channels) &&
+        entry->width == static_cast<std::uint32_t>(frequency) &&
+        entry->height == static_cast<std::uint32_t>(channels) && entry->pitch == format) {
+        return readyFuture(Mix_QuickLoad_RAW(static_cast<Uint8*>(mapped(bundle.data(*entry))),
+                                             static_cast<Uint32>(entry->size)));
+    }
+    const char* file = Assets::SOUNDS[static_cast<int>(sound)];
+    return pool.async([file] {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        Mix_Chunk* chunk = Mix_LoadWAV(file);
+        SDL_Log("Decoded %s in %.2f ms", file, millisecondsSince(start));
+        return chunk;
+    });
+}
+
+std::future<Mix_Music*> AssetLoader::loadMusic(Music music) {
+    const Bundle::Entry* entry = bundle.find(Bundle::EntryType::MUSIC, static_cast<std::uint32_t>(music));
+    if (entry) {
+        SDL_RWops* stream = SDL_RWFromConstMem(bundle.data(*entry), static_cast<int>(entry->size));
+        return readyFuture(stream ? Mix_LoadMUS_RW(stream, 1) : nullptr);
+    }
+    const char* file = Assets::MUSIC[static_cast<int>(music)];
+    return pool.async([file] {
+        const Uint64 start = SDL_GetPerformanceCounter();
+        Mix_Music* result = Mix_LoadMUS(file);
+        SDL_Log("Opened %s in %.2f ms", file, millisecondsSince(start));
+        return result;
+    });
+}
+
+TTF_Font* AssetLoader::openFont(int ptSize) {
+    const Bundle::Entry* entry = bundle.find(Bundle::EntryType::FONT, 0);
+    if (!entry) return TTF_OpenFont(Assets::FONT, ptSize);
+    SDL_RWops* stream = SDL_RWFromConstMem(bundle.data(*entry), static_cast<int>(entry->size));
+    return stream ? TTF_OpenFontRW(stream, 1, ptSize) : nullptr;
+}
+
+void AssetLoader::waitIdle() {
+    pool.waitIdle();
+}
+
+double AssetLoader::elapsedMs() const {
+    return millisecondsSince(startCounter);
+}
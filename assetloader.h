@@ -0,0 +1,47 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <SDL_ttf.h>
+#include <chrono>
+#include <future>
+#include "assetbundle.h"
+#include "spriteatlas.h"
+#include "structs.h"
+#include "threadpool.h"
+
+// Produces images, sounds and fonts either straight from a memory-mapped
+// bundle or, for anything the bundle lacks, by decoding the loose files on a
+// worker pool. Only decoding happens on the workers; GPU uploads stay on the
+// main thread.
+class AssetLoader {
+private:
+    ThreadPool pool;
+    AssetBundle bundle;
+    Uint64 startCounter;
+
+public:
+    AssetLoader();
+
+    // Maps a bundle built by bundlepacker. Returns false if it is missing or invalid.
+    bool openBundle(const char* path);
+
+    std::future<SDL_Surface*> loadSprite(Sprite sprite);
+    std::future<Mix_Chunk*> loadChunk(Sound sound);
+    std::future<Mix_Music*> loadMusic(Music music);
+    TTF_Font* openFont(int ptSize);
+    // Decodes the bird and pipe sprites just to build their collision masks.
+    // Blocks until done.
+    bool loadCollisionMasks(CollisionMasks& masks);
+    void waitIdle();
+    // Milliseconds since the loader was created.
+    double elapsedMs() const;
+
+    template <typename T>
+    static bool isReady(const std::future<T>& pending) {
+        return pending.valid() && pending.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+};
+
+#endif // ASSETLOADER_H
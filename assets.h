@@ -0,0 +1,45 @@
+#ifndef ASSETS_H
+#define ASSETS_H
+
+#include "spriteatlas.h"
+#include "structs.h"
+
+// Where every asset comes from when it is loaded from loose files. The bundle
+// packer reads the same tables, so ids in a bundle match these enums.
+namespace Assets {
+    // Indexed by Sprite. Large images are shrunk towards the size they are drawn at.
+    inline constexpr SpriteSource SPRITES[] = {
+        {"picture/background_and_road.png", 1, false},
+        {"picture/logo.png", 1, false},
+        {"picture/pipe.png", 2, false},
+        {"picture/pipe.png", 2, true},
+        {"picture/player1.png", 4, false},
+        {"picture/player2.png", 4, false},
+        {"picture/speaker_on.png", 4, false},
+        {"picture/speaker_off.png", 4, false}
+    };
+    static_assert(sizeof(SPRITES) / sizeof(SPRITES[0]) == static_cast<int>(Sprite::COUNT), "one source per Sprite");
+
+    // Indexed by Sound.
+    inline constexpr const char* SOUNDS[] = {
+        "sound/sfx_die.wav",
+        "sound/sfx_hit.wav",
+        "sound/sfx_point.wav",
+        "sound/sfx_wing.wav",
+        "sound/clicking.wav",
+        "sound/falling.wav"
+    };
+    static_assert(sizeof(SOUNDS) / sizeof(SOUNDS[0]) == static_cast<int>(Sound::COUNT), "one file per Sound");
+
+    // Indexed by Music.
+    inline constexpr const char* MUSIC[] = {
+        "sound/sound at lobby.mp3",
+        "sound/sound effect while playing.mp3"
+    };
+    static_assert(sizeof(MUSIC) / sizeof(MUSIC[0]) == static_cast<int>(Music::COUNT), "one file per Music");
+
+    inline constexpr const char* FONT = "font/SVN-New Athletic M54.ttf";
+    inline constexpr const char* BUNDLE = "assets.fbpk";
+}
+
+#endif // ASSETS_H
@@ -0,0 +1,92 @@
+// Cost of the pixel collision narrow phase. Run it from the game directory:
+// bench_collision [pairs]
+// Builds the masks from the real sprites, then times pixelsOverlap() on
+// random bird and pipe positions whose bounding boxes collide, which is the
+// only case the simulation runs it for.
+#include <SDL.h>
+#include <SDL_image.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "assets.h"
+#include "collisionmask.h"
+#include "constants.h"
+#include "spriteatlas.h"
+
+namespace {
+
+constexpr int REPEATS = 50;
+
+struct Pair {
+    int bird;       // 0 or 1, which player's mask
+    int birdX;
+    int birdY;
+    int pipeX;
+    int gapTop;
+    int gapBottom;
+};
+
+// Positions spread over every way a box can touch a pipe: any horizontal
+// overlap, and a y anywhere outside the gap, down to the ground.
+std::vector<Pair> boxHits(int count) {
+    std::mt19937 rng(2024u);
+    const int birdX = Constants::WINDOW_WIDTH / 4;
+    std::uniform_int_distribution<int> pipeX(birdX - Constants::PIPE_WIDTH + 1, birdX + Constants::BIRD_SIZE - 1);
+    std::uniform_int_distribution<int> gapY(75 + Constants::PIPE_GAP / 2,
+                                            Constants::WINDOW_HEIGHT - 75 - Constants::PIPE_GAP / 2);
+    std::vector<Pair> pairs;
+    pairs.reserve(count);
+    while (static_cast<int>(pairs.size()) < count) {
+        const int gap = gapY(rng);
+        const int gapTop = gap - Constants::PIPE_GAP / 2;
+        const int gapBottom = gap + Constants::PIPE_GAP / 2;
+        const int y = static_cast<int>(rng() % (Constants::WINDOW_HEIGHT - Constants::BIRD_SIZE));
+        if (y >= gapTop && y + Constants::BIRD_SIZE <= gapBottom) continue;
+        pairs.push_back({static_cast<int>(rng() & 1), birdX, y, pipeX(rng), gapTop, gapBottom});
+    }
+    return pairs;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const int count = argc > 1 ? std::atoi(argv[1]) : 100000;
+    if (count <= 0) {
+        std::fprintf(stderr, "Usage: %s [pairs]\n", argv[0]);
+        return 1;
+    }
+    if (IMG_Init(IMG_INIT_PNG) == 0) {
+        std::fprintf(stderr, "IMG_Init failed: %s\n", IMG_GetError());
+        return 1;
+    }
+
+    SDL_Surface* surfaces[static_cast<int>(Sprite::COUNT)] = {};
+    for (Sprite sprite : {Sprite::PIPE, Sprite::PIPE_FLIPPED, Sprite::PLAYER1, Sprite::PLAYER2})
+        surfaces[static_cast<int>(sprite)] = SpriteAtlas::decode(Assets::SPRITES[static_cast<int>(sprite)]);
+    CollisionMasks masks;
+    const bool built = SpriteAtlas::collisionMasks(surfaces, masks);
+    for (SDL_Surface* surface : surfaces) SDL_FreeSurface(surface);
+    IMG_Quit();
+    if (!built) {
+        std::fprintf(stderr, "Cannot build collision masks from the sprites\n");
+        return 1;
+    }
+
+    const std::vector<Pair> pairs = boxHits(count);
+    using Clock = std::chrono::steady_clock;
+    long long hits = 0;
+    const Clock::time_point begin = Clock::now();
+    for (int repeat = 0; repeat < REPEATS; repeat++) {
+        for (const Pair& pair : pairs)
+            hits += pixelsOverlap(masks.birds[pair.bird], pair.birdX, pair.birdY, masks,
+                                  pair.pipeX, pair.gapTop, pair.gapBottom);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    const double tests = static_cast<double>(count) * REPEATS;
+
+    std::printf("%d box hits x %d: %.1f ns per bird-pipe pair, %.1f%% are pixel hits\n",
+                count, REPEATS, seconds * 1e9 / tests, 100.0 * hits / tests);
+    return 0;
+}
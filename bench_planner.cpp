@@ -0,0 +1,60 @@
+#include "planner.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Survival benchmark for the lookahead planner under the current physics constants.
+// Usage: bench_planner [games per budget] [seconds of play per game]
+// Plays seeded one-bird games with the planner at several per-tick time
+// budgets and reports survival rate, score and search throughput.
+
+namespace {
+
+constexpr int BUDGETS_US[] = {20, 100, 500, 2000};
+
+void runBudget(int budgetUs, int games, int ticksPerGame) {
+    Planner planner(budgetUs);
+    Simulation simulation;
+    int survived = 0;
+    long long points = 0;
+    long long ticks = 0;
+    for (int game = 0; game < games; game++) {
+        simulation.seed(1000u + static_cast<unsigned>(game));
+        simulation.reset(1);
+        simulation.start();
+        while (!simulation.isOver() && simulation.getTick() < static_cast<std::uint32_t>(ticksPerGame)) {
+            if (planner.decide(simulation, 0)) simulation.flap(0);
+            simulation.step();
+            simulation.clearEvents();
+        }
+        // A bird that hit a pipe is still falling when the game is cut off.
+        const BirdPopulation& birds = simulation.getBirds();
+        if (!simulation.isOver() && !birds.isCollided(0)) survived++;
+        points += birds.getScore()[0];
+        ticks += simulation.getTick();
+    }
+
+    const PlannerStats& stats = planner.getStats();
+    std::printf("%6d us: %5.1f%% survived %8.1f avg score %12.0f nodes/sec %6.1f avg depth %6.1f%% cut short %8.1f us/tick\n",
+                budgetUs, 100.0 * survived / games, static_cast<double>(points) / games,
+                stats.nodes / stats.seconds, static_cast<double>(stats.depthSum) / stats.searches,
+                100.0 * stats.truncated / stats.searches, stats.seconds * 1e6 / ticks);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const int games = argc > 1 ? std::atoi(argv[1]) : 10;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 60.0;
+    if (games <= 0 || seconds <= 0) {
+        std::fprintf(stderr, "Usage: %s [games per budget] [seconds of play per game]\n", argv[0]);
+        return 1;
+    }
+    const int ticksPerGame = static_cast<int>(seconds * Constants::TICK_RATE);
+    std::printf("gravity %.2f, flap %.1f, pipe speed %d, gap %d, spacing %d, horizon %d ticks\n",
+                Constants::GRAVITY, Constants::FLAP_VELOCITY, Constants::PIPE_SPEED, Constants::PIPE_GAP,
+                Constants::PIPE_SPACING, Planner::DEFAULT_HORIZON);
+    std::printf("%d games of up to %.0f s per budget\n", games, seconds);
+    for (int budgetUs : BUDGETS_US) runBudget(budgetUs, games, ticksPerGame);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "birdpopulation.h"
+#include "constants.h"
+#include "structs.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// Micro-benchmark: per-Bird physics loop against the BirdPopulation kernels.
+// Usage: bench_population [ticks]
+
+namespace {
+
+constexpr int FLAP_INTERVAL = 16;
+
+// The per-Bird loop the game used before BirdPopulation, minus the sound call.
+int updateBirds(std::vector<Bird>& birds) {
+    int falls = 0;
+    for (auto& bird : birds) {
+        bird.velocity += Constants::GRAVITY;
+        bird.y += bird.velocity;
+        if (bird.y + Constants::BIRD_SIZE >= Constants::WINDOW_HEIGHT) {
+            if (bird.collided) bird.alive = false;
+            else if (bird.alive) {
+                falls++;
+                bird.alive = false;
+            }
+        }
+        if (bird.y < 0) {
+            bird.y = 0;
+            bird.velocity = 0;
+        }
+    }
+    return falls;
+}
+
+// Birds below a spread of thresholds flap, so they die at different ticks.
+void flapBirds(std::vector<Bird>& birds) {
+    for (size_t i = 0; i < birds.size(); i++)
+        if (birds[i].alive && birds[i].y > 200 + static_cast<float>(i % 97) * 2)
+            birds[i].velocity = Constants::FLAP_VELOCITY;
+}
+
+void flapBirds(BirdPopulation& birds) {
+    const float* y = birds.getY();
+    float* velocity = birds.getVelocity();
+    for (int i = 0; i < birds.size(); i++)
+        if (birds.isAlive(i) && y[i] > 200 + static_cast<float>(i % 97) * 2)
+            velocity[i] = Constants::FLAP_VELOCITY;
+}
+
+template <typename Step>
+double timeTicks(int ticks, Step step) {
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point begin = Clock::now();
+    for (int tick = 0; tick < ticks; tick++) step(tick);
+    return std::chrono::duration<double>(Clock::now() - begin).count();
+}
+
+void runBenchmark(int count, int ticks) {
+    const float startY = Constants::WINDOW_HEIGHT / 2.0f;
+    std::vector<Bird> aos(count, Bird(startY));
+    BirdPopulation soa;
+    soa.reset(count, startY);
+
+    long long aosFalls = 0, soaFalls = 0;
+    const double aosSeconds = timeTicks(ticks, [&](int tick) {
+        if (tick % FLAP_INTERVAL == 0) flapBirds(aos);
+        aosFalls += updateBirds(aos);
+    });
+    const double soaSeconds = timeTicks(ticks, [&](int tick) {
+        if (tick % FLAP_INTERVAL == 0) flapBirds(soa);
+        soaFalls += soa.integrate();
+    });
+
+    int mismatches = 0;
+    for (int i = 0; i < count; i++)
+        if (aos[i].y != soa.getY()[i] || aos[i].alive != soa.isAlive(i)) mismatches++;
+
+    const double birdTicks = static_cast<double>(count) * ticks;
+    std::printf("%7d birds: per-Bird %6.2f ns/bird  population %6.2f ns/bird  speedup %5.2fx  falls %lld/%lld%s\n",
+                count, aosSeconds * 1e9 / birdTicks, soaSeconds * 1e9 / birdTicks, aosSeconds / soaSeconds,
+                aosFalls, soaFalls, mismatches ? "  MISMATCH" : "");
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const int ticks = argc > 1 ? std::atoi(argv[1]) : 2000;
+#if defined(__AVX2__)
+    std::printf("kernel: AVX2\n");
+#elif defined(__SSE2__) || defined(_M_X64)
+    std::printf("kernel: SSE2\n");
+#else
+    std::printf("kernel: scalar\n");
+#endif
+    runBenchmark(1000, ticks);
+    runBenchmark(10000, ticks);
+    runBenchmark(100000, ticks);
+    return 0;
+}
@@ -0,0 +1,221 @@
+// Loopback test of the rollback netcode.
+// Usage: bench_rollback [players] [latency ms] [jitter ms] [loss %] [games] [base port]
+// Runs every player's session in this process over real UDP sockets on
+// 127.0.0.1, on a simulated clock so a minute of play takes well under a
+// second. Each outgoing packet is delayed by latency +- jitter and dropped
+// with the given chance, and each player's clock runs a little fast so time
+// sync has something to correct. Bots fly the birds from each player's own
+// predicted view. Exits with status 1 if any two players end a game in
+// different states or a recorded game does not replay to the same result.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include "rollback.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr std::uint64_t TICK_NS = 1000000000ull / Constants::TICK_RATE;
+constexpr std::uint64_t CLOCK_STEP_NS = 250000;
+constexpr std::uint32_t MAX_TICKS_PER_GAME = Constants::TICK_RATE * 300;
+constexpr int SNAPSHOT_REPEATS = 1000000;
+
+struct Peer {
+    RollbackSession session;
+    Simulation simulation;
+    Replay recording;
+    std::minstd_rand bot;
+    std::uint64_t period = TICK_NS;
+    std::uint64_t nextTick = 0;
+    int lapse = 0;          // Ticks left in which the bot does nothing
+};
+
+// The bench_simulation autopilot for one bird, with the odd lapse of
+// attention so games end.
+bool botFlaps(Peer& peer, int bird) {
+    if (peer.lapse > 0) {
+        peer.lapse--;
+        return false;
+    }
+    if (peer.bot() % 900 == 0) peer.lapse = 45;
+    const BirdPopulation& birds = peer.simulation.getBirds();
+    const int birdX = peer.simulation.getBirdX(bird);
+    int gapY = Constants::WINDOW_HEIGHT / 2;
+    for (const Pipe& pipe : peer.simulation.getPipes()) {
+        if (pipe.x + Constants::PIPE_WIDTH >= birdX) {
+            gapY = pipe.gapY;
+            break;
+        }
+    }
+    return birds.getY()[bird] + Constants::BIRD_SIZE > gapY + Constants::PIPE_GAP / 2 - 12 &&
+           birds.getVelocity()[bird] > 0;
+}
+
+std::uint32_t checksum(const Simulation& simulation) {
+    std::uint32_t hash = 2166136261u;
+    auto mix = [&hash](const void* data, std::size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (std::size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 16777619u;
+    };
+    const BirdPopulation& birds = simulation.getBirds();
+    const std::size_t n = static_cast<std::size_t>(birds.size());
+    mix(birds.getY(), n * sizeof(float));
+    mix(birds.getVelocity(), n * sizeof(float));
+    mix(birds.getAlive(), n * sizeof(std::int32_t));
+    mix(birds.getCollided(), n * sizeof(std::int32_t));
+    mix(birds.getScore(), n * sizeof(std::int32_t));
+    for (const Pipe& pipe : simulation.getPipes()) {
+        mix(&pipe.x, sizeof(pipe.x));
+        mix(&pipe.gapY, sizeof(pipe.gapY));
+    }
+    const std::uint32_t tick = simulation.getTick();
+    const int winner = simulation.getWinner();
+    mix(&tick, sizeof(tick));
+    mix(&winner, sizeof(winner));
+    return hash;
+}
+
+// Cost of one save and one load for a game of players birds, in
+// nanoseconds. Returns the bytes one save copies.
+std::size_t timeSnapshots(int players, double& saveNs, double& loadNs) {
+    Simulation simulation(7u);
+    simulation.reset(players);
+    simulation.start();
+    for (int i = 0; i < 100; i++) simulation.step();
+    SimState state;
+    simulation.saveState(state);
+
+    Clock::time_point begin = Clock::now();
+    for (int i = 0; i < SNAPSHOT_REPEATS; i++) simulation.saveState(state);
+    saveNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / SNAPSHOT_REPEATS;
+    begin = Clock::now();
+    for (int i = 0; i < SNAPSHOT_REPEATS; i++) simulation.loadState(state);
+    loadNs = std::chrono::duration<double, std::nano>(Clock::now() - begin).count() / SNAPSHOT_REPEATS;
+    // Three float and five int lanes per bird, plus the pipe ring.
+    return static_cast<std::size_t>(state.birds.paddedSize()) * 8 * 4 + sizeof(PipeQueue);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const int players = argc > 1 ? std::atoi(argv[1]) : 2;
+    const int latencyMs = argc > 2 ? std::atoi(argv[2]) : 40;
+    const int jitterMs = argc > 3 ? std::atoi(argv[3]) : 10;
+    const int lossPercent = argc > 4 ? std::atoi(argv[4]) : 5;
+    const int games = argc > 5 ? std::atoi(argv[5]) : 20;
+    const int basePort = argc > 6 ? std::atoi(argv[6]) : 47800;
+    if (players < 2 || players > NET_MAX_PLAYERS || latencyMs < 0 || jitterMs < 0 || jitterMs > latencyMs ||
+        lossPercent < 0 || lossPercent >= 100 || games < 1 || basePort < 1024 || basePort + players > 65535) {
+        std::fprintf(stderr, "Usage: %s [players 2-%d] [latency ms] [jitter ms <= latency] [loss %%] [games] [base port]\n",
+                     argv[0], NET_MAX_PLAYERS);
+        return 1;
+    }
+
+    double saveNs, loadNs;
+    const std::size_t stateBytes = timeSnapshots(players, saveNs, loadNs);
+    std::printf("%d players: state save %.1f ns, load %.1f ns, %zu bytes\n", players, saveNs, loadNs, stateBytes);
+
+    Peer* peers = new Peer[players];
+    NetStats total;
+    long long desyncs = 0, badReplays = 0, unfinished = 0;
+    std::uint64_t worstUpdateNs = 0, updateNs = 0, updates = 0;
+    for (int game = 0; game < games; game++) {
+        NetConfig config;
+        config.players = players;
+        config.seed = 1000u + static_cast<std::uint32_t>(game);
+        config.latencyMs = latencyMs;
+        config.jitterMs = jitterMs;
+        config.lossPercent = lossPercent;
+        for (int p = 0; p < players; p++) config.peers[p] = {0x7f000001u, static_cast<std::uint16_t>(basePort + p)};
+        for (int p = 0; p < players; p++) {
+            Peer& peer = peers[p];
+            config.localPlayer = p;
+            config.localPort = static_cast<std::uint16_t>(basePort + p);
+            if (!peer.session.open(config)) {
+                std::fprintf(stderr, "Cannot open UDP port %d\n", basePort + p);
+                return 1;
+            }
+            peer.recording.inputs.clear();
+            peer.recording.inputs.reserve(1 << 14);
+            peer.session.setRecording(&peer.recording);
+            peer.bot.seed(static_cast<std::uint32_t>(game * NET_MAX_PLAYERS + p + 1));
+            peer.lapse = 0;
+            // Up to 1% fast, and started a few milliseconds apart.
+            peer.period = TICK_NS - TICK_NS * p / (100 * NET_MAX_PLAYERS);
+            peer.nextTick = static_cast<std::uint64_t>(p) * 7000000;
+        }
+
+        std::uint64_t now = 0;
+        bool cut = false;
+        for (;;) {
+            bool finished = true;
+            for (int p = 0; p < players; p++)
+                finished = finished && peers[p].session.isConfirmedOver(peers[p].simulation);
+            if (finished) break;
+            if (now >= MAX_TICKS_PER_GAME * TICK_NS) {
+                cut = true;
+                break;
+            }
+            for (int p = 0; p < players; p++) {
+                Peer& peer = peers[p];
+                if (now < peer.nextTick) continue;
+                peer.nextTick += peer.period;
+                const bool flap = peer.session.isRunning() && botFlaps(peer, p);
+                const Clock::time_point begin = Clock::now();
+                peer.session.update(peer.simulation, flap, now);
+                const std::uint64_t spent = static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - begin).count());
+                worstUpdateNs = std::max(worstUpdateNs, spent);
+                updateNs += spent;
+                updates++;
+            }
+            now += CLOCK_STEP_NS;
+        }
+
+        // A game cut short has unconfirmed ticks left, so only finished ones are compared.
+        unfinished += cut;
+        const std::uint32_t expected = checksum(peers[0].simulation);
+        for (int p = 0; p < players; p++) {
+            Peer& peer = peers[p];
+            if (!cut && checksum(peer.simulation) != expected) desyncs++;
+            peer.recording.seed = peer.session.getSeed();
+            peer.recording.players = players;
+            peer.recording.endTick = peer.simulation.getTick();
+            const BirdPopulation& birds = peer.simulation.getBirds();
+            peer.recording.scores.assign(birds.getScore(), birds.getScore() + birds.size());
+            Simulation replayed;
+            if (!cut && !replayMatches(peer.recording, simulateReplay(peer.recording, replayed))) badReplays++;
+
+            const NetStats& stats = peer.session.getStats();
+            total.ticks += stats.ticks;
+            total.rollbacks += stats.rollbacks;
+            total.resimulatedTicks += stats.resimulatedTicks;
+            total.maxRollback = std::max(total.maxRollback, stats.maxRollback);
+            total.stalls += stats.stalls;
+            total.waits += stats.waits;
+            total.packetsSent += stats.packetsSent;
+            total.packetsReceived += stats.packetsReceived;
+            total.packetsDropped += stats.packetsDropped;
+            total.bytesSent += stats.bytesSent;
+            peer.session.close();
+        }
+    }
+    delete[] peers;
+
+    const double ticks = static_cast<double>(std::max(total.ticks, 1LL));
+    std::printf("%d games, %d ms +- %d ms, %d%% loss: %lld ticks\n", games, latencyMs, jitterMs, lossPercent, total.ticks);
+    std::printf("  rollbacks: %.1f per 100 ticks, %.2f ticks each on average, %d at most\n",
+                100.0 * total.rollbacks / ticks,
+                total.rollbacks ? static_cast<double>(total.resimulatedTicks) / total.rollbacks : 0.0, total.maxRollback);
+    std::printf("  stalled %.2f%% and waited %.2f%% of ticks\n", 100.0 * total.stalls / ticks, 100.0 * total.waits / ticks);
+    std::printf("  update: %.2f us on average, %.1f us at most\n",
+                updates ? updateNs / 1000.0 / updates : 0.0, worstUpdateNs / 1000.0);
+    std::printf("  packets: %lld sent, %lld dropped, %lld received, %.1f bytes per packet\n",
+                total.packetsSent, total.packetsDropped, total.packetsReceived,
+                total.packetsSent ? static_cast<double>(total.bytesSent) / total.packetsSent : 0.0);
+    std::printf("  %lld desynced players, %lld replays not matching, %lld games cut at %u ticks\n",
+                desyncs, badReplays, unfinished, MAX_TICKS_PER_GAME);
+    return desyncs == 0 && badReplays == 0 ? 0 : 1;
+}
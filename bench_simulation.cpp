@@ -0,0 +1,103 @@
+#include "simulation.h"
+#include "alloccounter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Headless throughput benchmark for the simulation core.
+// Usage: bench_simulation [crowd birds] [seconds per run]
+// Exits with status 1 if the steady-state game loop allocates.
+
+namespace {
+
+constexpr int MAX_TICKS_PER_GAME = 20000;
+constexpr int ALLOCATION_CHECK_TICKS = 1000000;
+
+// Flaps whenever a bird sinks close to the bottom of the next pipe gap, which keeps
+// games long enough to exercise pipe spawning and scoring.
+void autopilot(Simulation& simulation) {
+    const BirdPopulation& birds = simulation.getBirds();
+    const float* birdY = birds.getY();
+    const float* velocity = birds.getVelocity();
+    const PipeQueue& pipes = simulation.getPipes();
+    for (int i = 0; i < birds.size(); i++) {
+        const int birdX = simulation.getBirdX(i);
+        int gapY = Constants::WINDOW_HEIGHT / 2;
+        for (const Pipe& pipe : pipes) {
+            if (pipe.x + Constants::PIPE_WIDTH >= birdX) {
+                gapY = pipe.gapY;
+                break;
+            }
+        }
+        if (birdY[i] + Constants::BIRD_SIZE > gapY + Constants::PIPE_GAP / 2 - 12 && velocity[i] > 0)
+            simulation.flap(i);
+    }
+}
+
+void runBenchmark(int players, double seconds) {
+    using Clock = std::chrono::steady_clock;
+    Simulation simulation(12345u);
+    long long steps = 0;
+    long long games = 0;
+    long long points = 0;
+
+    const Clock::time_point begin = Clock::now();
+    const Clock::time_point deadline = begin + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+    while (Clock::now() < deadline) {
+        simulation.reset(players);
+        simulation.start();
+        for (int tick = 0; tick < MAX_TICKS_PER_GAME && !simulation.isOver(); tick++) {
+            autopilot(simulation);
+            simulation.step();
+            simulation.clearEvents();
+            steps++;
+        }
+        const BirdPopulation& birds = simulation.getBirds();
+        for (int i = 0; i < birds.size(); i++) points += birds.getScore()[i];
+        games++;
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    std::printf("%6d birds: %12.0f steps/sec %10.1f games/sec %8.1f avg score\n",
+                players, steps / elapsed, games / elapsed,
+                static_cast<double>(points) / (games * players));
+}
+
+// Plays back-to-back games for ALLOCATION_CHECK_TICKS ticks after one warm-up
+// game and returns the number of heap allocations made meanwhile.
+std::size_t countSteadyStateAllocations(int players) {
+    Simulation simulation(54321u);
+    auto playTicks = [&](int ticks) {
+        for (int tick = 0; tick < ticks; tick++) {
+            if (simulation.isOver()) {
+                simulation.reset(players);
+                simulation.start();
+            }
+            autopilot(simulation);
+            simulation.step();
+            simulation.clearEvents();
+        }
+    };
+    simulation.reset(players);
+    simulation.start();
+    playTicks(MAX_TICKS_PER_GAME);
+
+    const std::size_t before = AllocCounter::count();
+    playTicks(ALLOCATION_CHECK_TICKS);
+    return AllocCounter::count() - before;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const int crowd = argc > 1 ? std::atoi(argv[1]) : 64;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+    runBenchmark(1, seconds);
+    runBenchmark(2, seconds);
+    if (crowd > 2) runBenchmark(crowd, seconds);
+
+    const std::size_t allocations = countSteadyStateAllocations(2);
+    std::printf("heap allocations in %d steady-state ticks: %zu\n", ALLOCATION_CHECK_TICKS, allocations);
+    return allocations == 0 ? 0 : 1;
+}
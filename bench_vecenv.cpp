@@ -0,0 +1,81 @@
+#include "vecenv.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// Environment steps per second of VecEnv as the thread count doubles from 1 to 64.
+// Usage: bench_vecenv [worlds] [seconds per run]
+// Every run steps the same seeds with the same policy for a fixed number of
+// steps first and prints a checksum and the games finished, which must match
+// the 1-thread run; any run that differs is marked and the exit code is 1.
+
+namespace {
+
+constexpr int CHECKSUM_STEPS = 2000;
+
+// Flaps when the bird sinks below the middle of the next gap while falling.
+void policy(const VecEnv& env, std::vector<std::uint8_t>& actions) {
+    const float* observations = env.getObservations();
+    for (int agent = 0; agent < env.getAgentCount(); agent++) {
+        const float* observation = observations + agent * VecEnv::OBSERVATION_SIZE;
+        actions[agent] = observation[3] < -0.05f && observation[1] > 0.0f;
+    }
+}
+
+struct Baseline {
+    double rate = 0.0;
+    double checksum = 0.0;
+    long long games = 0;
+};
+
+// Returns false if the checksum or game count differs from the 1-thread run.
+bool runBenchmark(int worlds, int threads, double seconds, Baseline& baseline) {
+    using Clock = std::chrono::steady_clock;
+    VecEnv env(worlds, 1, threads);
+    std::vector<std::uint32_t> seeds(worlds);
+    for (int i = 0; i < worlds; i++) seeds[i] = static_cast<std::uint32_t>(i + 1);
+    std::vector<std::uint8_t> actions(env.getAgentCount());
+
+    env.reset(seeds.data());
+    double checksum = 0.0;
+    long long games = 0;
+    for (int step = 0; step < CHECKSUM_STEPS; step++) {
+        policy(env, actions);
+        env.step(actions.data());
+        for (int agent = 0; agent < env.getAgentCount(); agent++) checksum += env.getRewards()[agent];
+        for (int world = 0; world < worlds; world++) games += env.getDones()[world];
+    }
+
+    long long steps = 0;
+    const Clock::time_point begin = Clock::now();
+    const Clock::time_point deadline = begin + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+    while (Clock::now() < deadline) {
+        policy(env, actions);
+        env.step(actions.data());
+        steps += worlds;
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+    const double rate = steps / elapsed;
+    if (threads == 1) baseline = {rate, checksum, games};
+    const bool matches = checksum == baseline.checksum && games == baseline.games;
+    std::printf("%3d threads: %12.0f env steps/sec %6.2fx   checksum %.1f over %lld games%s\n",
+                threads, rate, rate / baseline.rate, checksum, games, matches ? "" : "  MISMATCH");
+    return matches;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const int worlds = argc > 1 ? std::atoi(argv[1]) : 4096;
+    const double seconds = argc > 2 ? std::atof(argv[2]) : 2.0;
+    if (worlds <= 0 || seconds <= 0) return 1;
+    std::printf("%d worlds, %u hardware threads\n", worlds, std::thread::hardware_concurrency());
+    Baseline baseline;
+    bool matches = true;
+    for (int threads = 1; threads <= 64; threads *= 2)
+        if (!runBenchmark(worlds, threads, seconds, baseline)) matches = false;
+    return matches ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+#include "birdpopulation.h"
+#include "constants.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr std::size_t ALIGNMENT = 32;
+constexpr int NIBBLE_BITS[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+template <typename T>
+T* allocateLanes(int n) {
+    return static_cast<T*>(::operator new[](n * sizeof(T), std::align_val_t(ALIGNMENT)));
+}
+
+template <typename T>
+void freeLanes(T* p) {
+    ::operator delete[](p, std::align_val_t(ALIGNMENT));
+}
+
+}
+
+BirdPopulation::~BirdPopulation() {
+    release();
+}
+
+BirdPopulation::BirdPopulation(const BirdPopulation& other) {
+    *this = other;
+}
+
+BirdPopulation& BirdPopulation::operator=(const BirdPopulation& other) {
+    if (this == &other) return *this;
+    if (capacity != other.capacity) {
+        release();
+        capacity = other.capacity;
+        if (capacity > 0) {
+            y = allocateLanes<float>(capacity);
+            prevY = allocateLanes<float>(capacity);
+            velocity = allocateLanes<float>(capacity);
+            alive = allocateLanes<std::int32_t>(capacity);
+            collided = allocateLanes<std::int32_t>(capacity);
+            landed = allocateLanes<std::int32_t>(capacity);
+            hit = allocateLanes<std::int32_t>(capacity);
+            score = allocateLanes<std::int32_t>(capacity);
+        }
+    }
+    count = other.count;
+    if (capacity > 0) {
+        std::memcpy(y, other.y, capacity * sizeof(float));
+        std::memcpy(prevY, other.prevY, capacity * sizeof(float));
+        std::memcpy(velocity, other.velocity, capacity * sizeof(float));
+        std::memcpy(alive, other.alive, capacity * sizeof(std::int32_t));
+        std::memcpy(collided, other.collided, capacity * sizeof(std::int32_t));
+        std::memcpy(landed, other.landed, capacity * sizeof(std::int32_t));
+        std::memcpy(hit, other.hit, capacity * sizeof(std::int32_t));
+        std::memcpy(score, other.score, capacity * sizeof(std::int32_t));
+    }
+    return *this;
+}
+
+void BirdPopulation::release() {
+    freeLanes(y);
+    freeLanes(prevY);
+    freeLanes(velocity);
+    freeLanes(alive);
+    freeLanes(collided);
+    freeLanes(landed);
+    freeLanes(hit);
+    freeLanes(score);
+    y = prevY = velocity = nullptr;
+    alive = collided = landed = hit = score = nullptr;
+    capacity = 0;
+}
+
+void BirdPopulation::reset(int n, float startY) {
+    const int padded = (n + LANES - 1) / LANES * LANES;
+    if (padded > capacity) {
+        BirdPopulation grown;
+        grown.capacity = padded;
+        grown.y = allocateLanes<float>(padded);
+        grown.prevY = allocateLanes<float>(padded);
+        grown.velocity = allocateLanes<float>(padded);
+        grown.alive = allocateLanes<std::int32_t>(padded);
+        grown.collided = allocateLanes<std::int32_t>(padded);
+        grown.landed = allocateLanes<std::int32_t>(padded);
+        grown.hit = allocateLanes<std::int32_t>(padded);
+        grown.score = allocateLanes<std::int32_t>(padded);
+        std::swap(capacity, grown.capacity);
+        std::swap(y, grown.y);
+        std::swap(prevY, grown.prevY);
+        std::swap(velocity, grown.velocity);
+        std::swap(alive, grown.alive);
+        std::swap(collided, grown.collided);
+        std::swap(landed, grown.landed);
+        std::swap(hit, grown.hit);
+        std::swap(score, grown.score);
+    }
+    count = n;
+    std::fill(y, y + capacity, startY);
+    std::fill(prevY, prevY + capacity, startY);
+    std::fill(velocity, velocity + capacity, 0.0f);
+    std::fill(alive, alive + count, -1);
+    std::fill(alive + count, alive + capacity, 0);
+    std::fill(collided, collided + capacity, 0);
+    std::fill(landed, landed + capacity, 0);
+    std::fill(hit, hit + capacity, 0);
+    std::fill(score, score + capacity, 0);
+}
+
+void BirdPopulation::revive() {
+    std::fill(alive, alive + count, -1);
+    std::fill(collided, collided + capacity, 0);
+    std::fill(landed, landed + capacity, 0);
+    std::fill(hit, hit + capacity, 0);
+    std::fill(score, score + capacity, 0);
+}
+
+void BirdPopulation::savePositions() {
+    std::memcpy(prevY, y, capacity * sizeof(float));
+}
+
+int BirdPopulation::integrate() {
+    const float groundY = static_cast<float>(Constants::WINDOW_HEIGHT - Constants::BIRD_SIZE);
+    int landedCount = 0;
+    int i = 0;
+
+#if defined(__AVX2__)
+    const __m256 gravity = _mm256_set1_ps(Constants::GRAVITY);
+    const __m256 ground = _mm256_set1_ps(groundY);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i < capacity; i += 8) {
+        __m256 v = _mm256_add_ps(_mm256_load_ps(velocity + i), gravity);
+        __m256 py = _mm256_add_ps(_mm256_load_ps(y + i), v);
+        const __m256 onGround = _mm256_cmp_ps(py, ground, _CMP_GE_OQ);
+        const __m256 wasAlive = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(alive + i)));
+        const __m256 hit = _mm256_and_ps(wasAlive, onGround);
+        const __m256 aboveCeiling = _mm256_cmp_ps(py, zero, _CMP_LT_OQ);
+        py = _mm256_max_ps(py, zero);
+        v = _mm256_andnot_ps(aboveCeiling, v);
+        _mm256_store_ps(velocity + i, v);
+        _mm256_store_ps(y + i, py);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(alive + i), _mm256_castps_si256(_mm256_andnot_ps(onGround, wasAlive)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(landed + i), _mm256_castps_si256(hit));
+        const int bits = _mm256_movemask_ps(hit);
+        landedCount += NIBBLE_BITS[bits & 15] + NIBBLE_BITS[bits >> 4];
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    const __m128 gravity = _mm_set1_ps(Constants::GRAVITY);
+    const __m128 ground = _mm_set1_ps(groundY);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i < capacity; i += 4) {
+        __m128 v = _mm_add_ps(_mm_load_ps(velocity + i), gravity);
+        __m128 py = _mm_add_ps(_mm_load_ps(y + i), v);
+        const __m128 onGround = _mm_cmpge_ps(py, ground);
+        const __m128 wasAlive = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(alive + i)));
+        const __m128 hit = _mm_and_ps(wasAlive, onGround);
+        const __m128 aboveCeiling = _mm_cmplt_ps(py, zero);
+        py = _mm_max_ps(py, zero);
+        v = _mm_andnot_ps(aboveCeiling, v);
+        _mm_store_ps(velocity + i, v);
+        _mm_store_ps(y + i, py);
+        _mm_store_si128(reinterpret_cast<__m128i*>(alive + i), _mm_castps_si128(_mm_andnot_ps(onGround, wasAlive)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(landed + i), _mm_castps_si128(hit));
+        landedCount += NIBBLE_BITS[_mm_movemask_ps(hit)];
+    }
+#endif
+
+    // Scalar fallback, written without branches so the compiler can vectorize it.
+    for (; i < capacity; i++) {
+        const float v = velocity[i] + Constants::GRAVITY;
+        const float py = y[i] + v;
+        const std::int32_t onGround = -static_cast<std::int32_t>(py >= groundY);
+        const std::int32_t hit = alive[i] & onGround;
+        const bool aboveCeiling = py < 0.0f;
+        velocity[i] = aboveCeiling ? 0.0f : v;
+        y[i] = aboveCeiling ? 0.0f : py;
+        alive[i] &= ~onGround;
+        landed[i] = hit;
+        landedCount -= hit;
+    }
+    return landedCount;
+}
+
+int BirdPopulation::collideGap(int begin, int end, int gapTop, int gapBottom) {
+    // The game tests collisions on the integer part of y, and y is never
+    // negative, so (int)y + BIRD_SIZE > gapBottom is y >= gapBottom - BIRD_SIZE + 1.
+    const float top = static_cast<float>(gapTop);
+    const float lowest = static_cast<float>(gapBottom - Constants::BIRD_SIZE + 1);
+    int hitCount = 0;
+    int i = begin;
+
+    auto collideOne = [&](int j) {
+        const std::int32_t outside = -static_cast<std::int32_t>((y[j] < top) | (y[j] >= lowest));
+        const std::int32_t newHit = alive[j] & ~collided[j] & outside;
+        collided[j] |= newHit;
+        hit[j] = newHit;
+        hitCount -= newHit;
+    };
+
+#if defined(__AVX2__)
+    for (; i < end && i % 8 != 0; i++) collideOne(i);
+    const __m256 topLanes = _mm256_set1_ps(top);
+    const __m256 lowestLanes = _mm256_set1_ps(lowest);
+    for (; i + 8 <= end; i += 8) {
+        const __m256 py = _mm256_load_ps(y + i);
+        const __m256 outside = _mm256_or_ps(_mm256_cmp_ps(py, topLanes, _CMP_LT_OQ),
+                                            _mm256_cmp_ps(py, lowestLanes, _CMP_GE_OQ));
+        const __m256 wasCollided = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(collided + i)));
+        const __m256 isAlive = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(alive + i)));
+        const __m256 newHit = _mm256_and_ps(_mm256_andnot_ps(wasCollided, isAlive), outside);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(collided + i), _mm256_castps_si256(_mm256_or_ps(wasCollided, newHit)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(hit + i), _mm256_castps_si256(newHit));
+        const int bits = _mm256_movemask_ps(newHit);
+        hitCount += NIBBLE_BITS[bits & 15] + NIBBLE_BITS[bits >> 4];
+    }
+#elif defined(__SSE2__) || defined(_M_X64)
+    for (; i < end && i % 4 != 0; i++) collideOne(i);
+    const __m128 topLanes = _mm_set1_ps(top);
+    const __m128 lowestLanes = _mm_set1_ps(lowest);
+    for (; i + 4 <= end; i += 4) {
+        const __m128 py = _mm_load_ps(y + i);
+        const __m128 outside = _mm_or_ps(_mm_cmplt_ps(py, topLanes), _mm_cmpge_ps(py, lowestLanes));
+        const __m128 wasCollided = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(collided + i)));
+        const __m128 isAlive = _mm_castsi128_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(alive + i)));
+        const __m128 newHit = _mm_and_ps(_mm_andnot_ps(wasCollided, isAlive), outside);
+        _mm_store_si128(reinterpret_cast<__m128i*>(collided + i), _mm_castps_si128(_mm_or_ps(wasCollided, newHit)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(hit + i), _mm_castps_si128(newHit));
+        hitCount += NIBBLE_BITS[_mm_movemask_ps(newHit)];
+    }
+#endif
+
+    for (; i < end; i++) collideOne(i);
+    return hitCount;
+}
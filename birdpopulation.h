@@ -0,0 +1,74 @@
+#ifndef BIRDPOPULATION_H
+#define BIRDPOPULATION_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Birds stored as separate aligned arrays (structure of arrays) so physics can
+// run over many birds with SIMD. alive and collided are lane masks: 0 or -1.
+// Arrays are padded to a multiple of LANES; padding lanes are never alive.
+class BirdPopulation {
+public:
+    static constexpr int LANES = 8;
+
+private:
+    int count = 0;
+    int capacity = 0;
+    float* y = nullptr;
+    float* prevY = nullptr;
+    float* velocity = nullptr;
+    std::int32_t* alive = nullptr;
+    std::int32_t* collided = nullptr;
+    std::int32_t* landed = nullptr;
+    std::int32_t* hit = nullptr;
+    std::int32_t* score = nullptr;
+
+    void release();
+
+public:
+    BirdPopulation() = default;
+    ~BirdPopulation();
+    BirdPopulation(const BirdPopulation& other);
+    BirdPopulation& operator=(const BirdPopulation& other);
+
+    // Resizes to n birds at startY with zero velocity and score, all alive.
+    void reset(int n, float startY);
+    // Revives every bird at its current position with zero score.
+    void revive();
+
+    // Applies gravity, the ceiling clamp and ground death to every bird.
+    // Birds that died on the ground this tick are flagged in getLanded().
+    // Returns how many birds landed.
+    int integrate();
+    // Marks alive, not yet collided birds in [begin, end) that are outside the
+    // gap [gapTop, gapBottom] of a pipe overlapping their column. New hits are
+    // flagged in getHit() for that range. Returns how many birds were hit.
+    int collideGap(int begin, int end, int gapTop, int gapBottom);
+    // Takes back a hit collideGap() just flagged, for a bird that only
+    // touched the pipe with its bounding box.
+    void clearHit(int i) { collided[i] = 0; hit[i] = 0; }
+    void savePositions();
+
+    int size() const { return count; }
+    // Number of elements in each array, including padding.
+    int paddedSize() const { return capacity; }
+    bool isAlive(int i) const { return alive[i] != 0; }
+    bool isCollided(int i) const { return collided[i] != 0; }
+
+    float* getY() { return y; }
+    float* getPrevY() { return prevY; }
+    float* getVelocity() { return velocity; }
+    std::int32_t* getAlive() { return alive; }
+    std::int32_t* getCollided() { return collided; }
+    std::int32_t* getScore() { return score; }
+    const float* getY() const { return y; }
+    const float* getPrevY() const { return prevY; }
+    const float* getVelocity() const { return velocity; }
+    const std::int32_t* getAlive() const { return alive; }
+    const std::int32_t* getCollided() const { return collided; }
+    const std::int32_t* getLanded() const { return landed; }
+    const std::int32_t* getHit() const { return hit; }
+    const std::int32_t* getScore() const { return score; }
+};
+
+#endif // BIRDPOPULATION_H
@@ -0,0 +1,158 @@
+// Offline tool that packs every game asset into one bundle the game can
+// memory-map. Run it from the game directory: bundlepacker [output]
+#include <SDL.h>
+#include <SDL_image.h>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include "assetbundle.h"
+#include "assets.h"
+#include "constants.h"
+
+namespace {
+
+struct PendingEntry {
+    Bundle::Entry entry;
+    std::vector<std::uint8_t> bytes;
+};
+
+bool readFile(const char* path, std::vector<std::uint8_t>& bytes) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+bool packImage(Sprite sprite, std::vector<PendingEntry>& out) {
+    const SpriteSource& source = Assets::SPRITES[static_cast<int>(sprite)];
+    SDL_Surface* surface = SpriteAtlas::decode(source);
+    if (!surface) {
+        std::fprintf(stderr, "Cannot decode %s: %s\n", source.file, SDL_GetError());
+        return false;
+    }
+    PendingEntry pending = {};
+    pending.entry.type = static_cast<std::uint32_t>(Bundle::EntryType::IMAGE);
+    pending.entry.id = static_cast<std::uint32_t>(sprite);
+    pending.entry.width = static_cast<std::uint32_t>(surface->w);
+    pending.entry.height = static_cast<std::uint32_t>(surface->h);
+    pending.entry.pitch = static_cast<std::uint32_t>(surface->w) * 4;
+    pending.bytes.resize(static_cast<std::size_t>(pending.entry.pitch) * pending.entry.height);
+    for (int y = 0; y < surface->h; y++) {
+        std::memcpy(pending.bytes.data() + static_cast<std::size_t>(y) * pending.entry.pitch,
+                    static_cast<const std::uint8_t*>(surface->pixels) + y * surface->pitch, pending.entry.pitch);
+    }
+    SDL_FreeSurface(surface);
+    out.push_back(std::move(pending));
+    return true;
+}
+
+// Converts a WAV file to the mixer output format so the game can play it without decoding.
+bool packSound(Sound sound, std::vector<PendingEntry>& out) {
+    const char* file = Assets::SOUNDS[static_cast<int>(sound)];
+    SDL_AudioSpec spec;
+    Uint8* samples = nullptr;
+    Uint32 length = 0;
+    if (!SDL_LoadWAV(file, &spec, &samples, &length)) {
+        std::fprintf(stderr, "Cannot load %s: %s\n", file, SDL_GetError());
+        return false;
+    }
+    SDL_AudioCVT cvt;
+    if (SDL_BuildAudioCVT(&cvt, spec.format, spec.channels, spec.freq,
+                          AUDIO_S16SYS, Constants::AUDIO_CHANNELS, Constants::AUDIO_FREQUENCY) < 0) {
+        std::fprintf(stderr, "Cannot convert %s: %s\n", file, SDL_GetError());
+        SDL_FreeWAV(samples);
+        return false;
+    }
+    std::vector<std::uint8_t> buffer(static_cast<std::size_t>(length) * cvt.len_mult);
+    std::memcpy(buffer.data(), samples, length);
+    SDL_FreeWAV(samples);
+    cvt.buf = buffer.data();
+    cvt.len = static_cast<int>(length);
+    if (cvt.needed && SDL_ConvertAudio(&cvt) < 0) {
+        std::fprintf(stderr, "Cannot convert %s: %s\n", file, SDL_GetError());
+        return false;
+    }
+    buffer.resize(cvt.needed ? static_cast<std::size_t>(cvt.len_cvt) : length);
+
+    PendingEntry pending = {};
+    pending.entry.type = static_cast<std::uint32_t>(Bundle::EntryType::SOUND);
+    pending.entry.id = static_cast<std::uint32_t>(sound);
+    pending.entry.width = Constants::AUDIO_FREQUENCY;
+    pending.entry.height = Constants::AUDIO_CHANNELS;
+    pending.entry.pitch = AUDIO_S16SYS;
+    pending.bytes = std::move(buffer);
+    out.push_back(std::move(pending));
+    return true;
+}
+
+bool packRaw(Bundle::EntryType type, std::uint32_t id, const char* file, std::vector<PendingEntry>& out) {
+    PendingEntry pending = {};
+    pending.entry.type = static_cast<std::uint32_t>(type);
+    pending.entry.id = id;
+    if (!readFile(file, pending.bytes)) {
+        std::fprintf(stderr, "Cannot read %s\n", file);
+        return false;
+    }
+    out.push_back(std::move(pending));
+    return true;
+}
+
+std::uint64_t alignUp(std::uint64_t offset) {
+    return (offset + Bundle::ALIGNMENT - 1) / Bundle::ALIGNMENT * Bundle::ALIGNMENT;
+}
+
+bool writeBundle(const char* path, std::vector<PendingEntry>& pending) {
+    Bundle::Header header = {};
+    std::memcpy(header.magic, Bundle::MAGIC, sizeof(header.magic));
+    header.version = Bundle::VERSION;
+    header.entryCount = static_cast<std::uint32_t>(pending.size());
+
+    std::uint64_t offset = sizeof(header) + pending.size() * sizeof(Bundle::Entry);
+    for (auto& item : pending) {
+        offset = alignUp(offset);
+        item.entry.offset = offset;
+        item.entry.size = item.bytes.size();
+        offset += item.bytes.size();
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const auto& item : pending) file.write(reinterpret_cast<const char*>(&item.entry), sizeof(item.entry));
+    const char zeros[Bundle::ALIGNMENT] = {};
+    for (const auto& item : pending) {
+        const std::uint64_t position = static_cast<std::uint64_t>(file.tellp());
+        file.write(zeros, static_cast<std::streamsize>(item.entry.offset - position));
+        file.write(reinterpret_cast<const char*>(item.bytes.data()), static_cast<std::streamsize>(item.bytes.size()));
+    }
+    return static_cast<bool>(file);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const char* output = argc > 1 ? argv[1] : Assets::BUNDLE;
+    if (IMG_Init(IMG_INIT_PNG) == 0) {
+        std::fprintf(stderr, "IMG_Init failed: %s\n", IMG_GetError());
+        return 1;
+    }
+
+    std::vector<PendingEntry> pending;
+    bool ok = true;
+    for (int i = 0; i < static_cast<int>(Sprite::COUNT); i++) ok = packImage(static_cast<Sprite>(i), pending) && ok;
+    for (int i = 0; i < static_cast<int>(Sound::COUNT); i++) ok = packSound(static_cast<Sound>(i), pending) && ok;
+    // Missing music is skipped; the game falls back to the loose file for any absent entry.
+    for (int i = 0; i < static_cast<int>(Music::COUNT); i++)
+        packRaw(Bundle::EntryType::MUSIC, static_cast<std::uint32_t>(i), Assets::MUSIC[i], pending);
+    ok = packRaw(Bundle::EntryType::FONT, 0, Assets::FONT, pending) && ok;
+    IMG_Quit();
+
+    if (!ok || !writeBundle(output, pending)) {
+        std::fprintf(stderr, "Failed to write %s\n", output);
+        return 1;
+    }
+    std::printf("Wrote %s with %zu entries\n", output, pending.size());
+    return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef BUTTON_H
+#define BUTTON_H
+
+#include <SDL.h>
+#include <string>
+
+enum class ButtonAction {
+    ONE_PLAYER,     // Bắt đầu chế độ 1 người
+    TWO_PLAYERS,    // Bắt đầu chế độ 2 người
+    INFORMATION,    // Mở màn hình thông tin
+    TOGGLE_SOUND,   // Bật/tắt nhạc
+    RETURN_TO_MENU, // Quay về menu
+    AI_BIRDS        // Xem quần thể chim AI tiến hóa
+};
+
+struct Button {
+    SDL_Rect rect;      // Hình chữ nhật xác định vị trí và kích thước nút
+    std::string text;   // Văn bản hiển thị trên nút
+    int originalW, originalH;  // Kích thước gốc của nút
+    bool hovered = false;      // Trạng thái chuột đang hover trên nút
+    bool isRed = false;        // Màu sắc của nút (đỏ hoặc không)
+    ButtonAction action;       // Hành động khi bấm nút
+    float hoverScale;          // Hệ số phóng to khi hover
+    SDL_Rect hoverRect{0, 0, 0, 0};  // Vùng chữ kích hoạt hover, đo lúc dựng layout
+    int textW = 0, textH = 0;        // Kích thước chữ khi vẽ, đo lúc dựng layout
+    Button(int x, int y, int w, int h, const std::string& t, ButtonAction a, float scale, bool red = false)
+        : rect{x, y, w, h}, text(t), originalW(w), originalH(h), isRed(red), action(a), hoverScale(scale) {}
+};
+
+#endif // BUTTON_H
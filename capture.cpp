@@ -0,0 +1,390 @@
+#include "capture.h"
+#include <SDL_image.h>
+#include <SDL_mixer.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include "profiler.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds AUDIO_WRITE_INTERVAL(20);
+constexpr std::uint32_t WAV_HEADER_BYTES = 44;
+
+const char* videoExtension(CaptureFormat format) {
+    switch (format) {
+        case CaptureFormat::Y4M: return "y4m";
+        case CaptureFormat::RAW: return "bgra";
+        case CaptureFormat::PNG: return "png";
+    }
+    return "";
+}
+
+void putLittleEndian(Uint8* out, std::uint32_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) out[i] = static_cast<Uint8>(value >> (8 * i));
+}
+
+bool writeWavHeader(std::FILE* file, int frequency, int channels, std::uint64_t dataBytes) {
+    const std::uint32_t data = static_cast<std::uint32_t>(std::min<std::uint64_t>(dataBytes, 0xffffffffu - WAV_HEADER_BYTES));
+    const std::uint32_t blockAlign = static_cast<std::uint32_t>(channels) * 2;
+    Uint8 header[WAV_HEADER_BYTES];
+    std::memcpy(header, "RIFF", 4);
+    putLittleEndian(header + 4, data + WAV_HEADER_BYTES - 8, 4);
+    std::memcpy(header + 8, "WAVEfmt ", 8);
+    putLittleEndian(header + 16, 16, 4);    // Format chunk size
+    putLittleEndian(header + 20, 1, 2);     // Integer PCM
+    putLittleEndian(header + 22, static_cast<std::uint32_t>(channels), 2);
+    putLittleEndian(header + 24, static_cast<std::uint32_t>(frequency), 4);
+    putLittleEndian(header + 28, static_cast<std::uint32_t>(frequency) * blockAlign, 4);
+    putLittleEndian(header + 32, blockAlign, 2);
+    putLittleEndian(header + 34, 16, 2);    // Bits per sample
+    std::memcpy(header + 36, "data", 4);
+    putLittleEndian(header + 40, data, 4);
+    return std::fwrite(header, 1, sizeof(header), file) == sizeof(header);
+}
+
+// BT.601 studio range, each chroma sample averaged over a 2x2 block.
+void argbToI420(const Uint8* pixels, int width, int height, Uint8* yuv) {
+    Uint8* yPlane = yuv;
+    Uint8* uPlane = yuv + width * height;
+    Uint8* vPlane = uPlane + (width / 2) * (height / 2);
+    for (int y = 0; y < height; y += 2) {
+        const Uint32* rows[2] = {reinterpret_cast<const Uint32*>(pixels) + y * width,
+                                 reinterpret_cast<const Uint32*>(pixels) + (y + 1) * width};
+        for (int x = 0; x < width; x += 2) {
+            int rSum = 0, gSum = 0, bSum = 0;
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    const Uint32 pixel = rows[dy][x + dx];
+                    const int r = (pixel >> 16) & 0xff;
+                    const int g = (pixel >> 8) & 0xff;
+                    const int b = pixel & 0xff;
+                    yPlane[(y + dy) * width + x + dx] = static_cast<Uint8>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                    rSum += r;
+                    gSum += g;
+                    bSum += b;
+                }
+            }
+            const int r = rSum / 4, g = gSum / 4, b = bSum / 4;
+            const int chroma = (y / 2) * (width / 2) + x / 2;
+            uPlane[chroma] = static_cast<Uint8>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+            vPlane[chroma] = static_cast<Uint8>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+        }
+    }
+}
+
+}
+
+GameCapture::~GameCapture() {
+    stop();
+}
+
+bool GameCapture::start(SDL_Renderer* renderer, const GameOptions& options) {
+    stop();
+    if (!options.captureDir || SDL_GetRendererOutputSize(renderer, &width, &height) != 0) return false;
+    format = options.captureFormat;
+    fps = options.captureFps;
+    // 4:2:0 chroma covers 2x2 blocks, so Y4M leaves out an odd last row or column.
+    if (format == CaptureFormat::Y4M) {
+        width &= ~1;
+        height &= ~1;
+    }
+    char stamp[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+    std::snprintf(basePath, sizeof(basePath), "%s/capture-%s", options.captureDir, stamp);
+
+    if (format != CaptureFormat::PNG) {
+        char path[540];
+        std::snprintf(path, sizeof(path), "%s.%s", basePath, videoExtension(format));
+        video = std::fopen(path, "wb");
+        if (!video) return false;
+        if (format == CaptureFormat::Y4M)
+            std::fprintf(video, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", width, height, fps);
+    }
+
+    const std::size_t frameBytes = static_cast<std::size_t>(width) * height * 4;
+    for (int i = 0; i < BUFFERS; i++) {
+        frames[i].pixels.resize(frameBytes);
+        frames[i].yuv.resize(format == CaptureFormat::Y4M ? frameBytes * 3 / 8 : 0);
+        freeFrames[i] = &frames[i];
+    }
+    freeCount = BUFFERS;
+    readyHead = 0;
+    readyCount = 0;
+    nextWrite = 0;
+    stopping = false;
+    writeFailed = false;
+    encodeTicks = 0;
+    encoded = 0;
+    queued = 0;
+    lastIndex = 0;
+    dropped = 0;
+    droppedIndex = 0;
+    pendingDrops = 0;
+    held = 0;
+    captureTicks = 0;
+    maxCaptureTicks = 0;
+    for (int i = 0; i < options.captureWorkers; i++) workers.emplace_back(&GameCapture::workerLoop, this);
+    if (!openAudio()) SDL_Log("Capturing without audio");
+
+    startedAt = SDL_GetPerformanceCounter();
+    active = true;
+    SDL_Log("Capturing %dx%d at %d fps to %s%s.%s", width, height, fps, basePath,
+            format == CaptureFormat::PNG ? "-<frame>" : "", videoExtension(format));
+    return true;
+}
+
+void GameCapture::stop() {
+    if (!active) return;
+    active = false;
+    const Uint64 stoppedAt = SDL_GetPerformanceCounter();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frameReady.notify_all();
+    for (std::thread& worker : workers) worker.join();
+    const int workerCount = static_cast<int>(workers.size());
+    workers.clear();
+    closeAudio();
+    if (video && std::fclose(video) != 0) writeFailed = true;
+    video = nullptr;
+
+    const double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+    const double seconds = (stoppedAt - startedAt) / frequency;
+    const double capturedFrames = static_cast<double>(std::max<std::uint64_t>(queued, 1));
+    SDL_Log("Captured %llu frames in %.1f s to %s: read back avg %.2f ms, max %.2f ms per frame;"
+            " encoded avg %.2f ms per frame on %d workers",
+            static_cast<unsigned long long>(queued), seconds, basePath, captureTicks * 1000.0 / frequency / capturedFrames,
+            maxCaptureTicks * 1000.0 / frequency, encodeTicks * 1000.0 / frequency / std::max<std::uint64_t>(encoded, 1),
+            workerCount);
+    if (held > 0)
+        SDL_Log("%llu capture samples had no frame of their own, %llu of them because every buffer was busy",
+                static_cast<unsigned long long>(held), static_cast<unsigned long long>(dropped));
+    if (audioFrequency > 0) {
+        const double bytesPerMs = audioFrequency * audioChannels * 2 / 1000.0;
+        SDL_Log("Captured %.1f s of audio, %.1f ms of it silence in place of buffers the writer missed",
+                audioWritten / bytesPerMs / 1000.0, audioSilence / bytesPerMs);
+    }
+    if (writeFailed) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Some of capture %s could not be written", basePath);
+}
+
+void GameCapture::captureFrame(SDL_Renderer* renderer) {
+    if (!active) return;
+    PROFILE_ZONE("capture");
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const std::uint64_t index = (start - startedAt) * fps / SDL_GetPerformanceFrequency();
+    // Rendering faster than the capture rate: this sample already has its frame.
+    if (queued > 0 && index <= lastIndex) return;
+    Frame* frame = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (freeCount > 0) frame = freeFrames[--freeCount];
+    }
+    if (!frame) {
+        // Counted once per sample, and only if no later try in it finds a buffer.
+        if (pendingDrops == 0 || index != droppedIndex) pendingDrops++;
+        droppedIndex = index;
+        return;
+    }
+    const SDL_Rect rect = {0, 0, width, height};
+    if (SDL_RenderReadPixels(renderer, &rect, SDL_PIXELFORMAT_ARGB8888, frame->pixels.data(), width * 4) != 0) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot read back the frame to capture: %s", SDL_GetError());
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            freeFrames[freeCount++] = frame;
+        }
+        stop();
+        return;
+    }
+    if (pendingDrops > 0 && droppedIndex == index) pendingDrops--;
+    dropped += pendingDrops;
+    pendingDrops = 0;
+    frame->index = index;
+    frame->sequence = queued;
+    // The first frame also covers the samples since start(), so the video lines up with the audio.
+    frame->repeats = queued == 0 ? index + 1 : index - lastIndex;
+    held += frame->repeats - 1;
+    lastIndex = index;
+    queued++;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readyFrames[(readyHead + readyCount) % BUFFERS] = frame;
+        readyCount++;
+    }
+    frameReady.notify_one();
+    const Uint64 ticks = SDL_GetPerformanceCounter() - start;
+    captureTicks += ticks;
+    maxCaptureTicks = std::max(maxCaptureTicks, ticks);
+}
+
+void GameCapture::workerLoop() {
+    for (;;) {
+        Frame* frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameReady.wait(lock, [this] { return stopping || readyCount > 0; });
+            if (readyCount == 0) return;
+            frame = readyFrames[readyHead];
+            readyHead = (readyHead + 1) % BUFFERS;
+            readyCount--;
+        }
+        Uint64 start = SDL_GetPerformanceCounter();
+        bool written = encode(*frame);
+        Uint64 ticks = SDL_GetPerformanceCounter() - start;
+        if (format != CaptureFormat::PNG) {
+            // Frames are encoded side by side but enter the stream in order.
+            std::unique_lock<std::mutex> lock(mutex);
+            writeTurn.wait(lock, [this, frame] { return nextWrite == frame->sequence; });
+            lock.unlock();
+            start = SDL_GetPerformanceCounter();
+            written = writeFrame(*frame) && written;
+            ticks += SDL_GetPerformanceCounter() - start;
+            lock.lock();
+            nextWrite++;
+            lock.unlock();
+            writeTurn.notify_all();
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        freeFrames[freeCount++] = frame;
+        if (!written) writeFailed = true;
+        encodeTicks += ticks;
+        encoded++;
+    }
+}
+
+bool GameCapture::encode(Frame& frame) {
+    switch (format) {
+        case CaptureFormat::Y4M:
+            argbToI420(frame.pixels.data(), width, height, frame.yuv.data());
+            return true;
+        case CaptureFormat::RAW:
+            return true;
+        case CaptureFormat::PNG: {
+            char path[560];
+            std::snprintf(path, sizeof(path), "%s-%06llu.png", basePath, static_cast<unsigned long long>(frame.index));
+            SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(frame.pixels.data(), width, height, 32, width * 4,
+                                                                      SDL_PIXELFORMAT_ARGB8888);
+            if (!surface) return false;
+            const bool saved = IMG_SavePNG(surface, path) == 0;
+            SDL_FreeSurface(surface);
+            return saved;
+        }
+    }
+    return false;
+}
+
+bool GameCapture::writeFrame(const Frame& frame) {
+    for (std::uint64_t i = 0; i < frame.repeats; i++) {
+        if (format == CaptureFormat::Y4M) {
+            if (std::fputs("FRAME\n", video) < 0 ||
+                std::fwrite(frame.yuv.data(), 1, frame.yuv.size(), video) != frame.yuv.size())
+                return false;
+        } else if (std::fwrite(frame.pixels.data(), 1, frame.pixels.size(), video) != frame.pixels.size()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GameCapture::openAudio() {
+    audioFrequency = 0;
+    int frequency, channels;
+    Uint16 sampleFormat;
+    if (Mix_QuerySpec(&frequency, &sampleFormat, &channels) == 0 || sampleFormat != AUDIO_S16LSB) return false;
+    char path[540];
+    std::snprintf(path, sizeof(path), "%s.wav", basePath);
+    audio = std::fopen(path, "wb");
+    if (!audio) return false;
+    // Sizes are filled in by closeAudio().
+    if (!writeWavHeader(audio, frequency, channels, 0)) {
+        std::fclose(audio);
+        audio = nullptr;
+        return false;
+    }
+    if (!audioRing) audioRing.reset(new Uint8[AUDIO_RING_BYTES]);
+    audioHead.store(0, std::memory_order_relaxed);
+    audioTail.store(0, std::memory_order_relaxed);
+    audioDropped.store(0, std::memory_order_relaxed);
+    audioWritten = 0;
+    audioSilence = 0;
+    audioFailed = false;
+    audioFrequency = frequency;
+    audioChannels = channels;
+    audioStopping = false;
+    audioWriter = std::thread(&GameCapture::audioLoop, this);
+    audioEnabled.store(true);
+    return true;
+}
+
+void GameCapture::closeAudio() {
+    if (!audio) return;
+    audioEnabled.store(false);
+    // A mixed buffer being copied right now still lands in the ring.
+    while (audioPushing.load() != 0) std::this_thread::yield();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        audioStopping = true;
+    }
+    audioWake.notify_all();
+    audioWriter.join();
+    if (audioFailed) writeFailed = true;
+    if (std::fseek(audio, 0, SEEK_SET) != 0 || !writeWavHeader(audio, audioFrequency, audioChannels, audioWritten))
+        writeFailed = true;
+    if (std::fclose(audio) != 0) writeFailed = true;
+    audio = nullptr;
+}
+
+void GameCapture::pushAudio(const Uint8* stream, int length) {
+    audioPushing.fetch_add(1);
+    if (audioEnabled.load() && length > 0) {
+        const std::size_t bytes = static_cast<std::size_t>(length);
+        const std::size_t tail = audioTail.load(std::memory_order_relaxed);
+        if (AUDIO_RING_BYTES - (tail - audioHead.load(std::memory_order_acquire)) < bytes) {
+            // Whole buffers only, so the samples stay aligned; the writer puts silence in their place.
+            audioDropped.fetch_add(bytes, std::memory_order_relaxed);
+        } else {
+            const std::size_t offset = tail & (AUDIO_RING_BYTES - 1);
+            const std::size_t first = std::min(bytes, AUDIO_RING_BYTES - offset);
+            std::memcpy(audioRing.get() + offset, stream, first);
+            std::memcpy(audioRing.get(), stream + first, bytes - first);
+            audioTail.store(tail + bytes, std::memory_order_release);
+        }
+    }
+    audioPushing.fetch_sub(1);
+}
+
+void GameCapture::audioLoop() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            audioWake.wait_for(lock, AUDIO_WRITE_INTERVAL, [this] { return audioStopping; });
+            if (audioStopping) break;
+        }
+        drainAudio();
+    }
+    drainAudio();
+}
+
+void GameCapture::drainAudio() {
+    const std::size_t tail = audioTail.load(std::memory_order_acquire);
+    std::size_t head = audioHead.load(std::memory_order_relaxed);
+    while (head != tail) {
+        const std::size_t offset = head & (AUDIO_RING_BYTES - 1);
+        const std::size_t chunk = std::min(tail - head, AUDIO_RING_BYTES - offset);
+        if (std::fwrite(audioRing.get() + offset, 1, chunk, audio) != chunk) audioFailed = true;
+        head += chunk;
+        audioWritten += chunk;
+    }
+    audioHead.store(head, std::memory_order_release);
+    static const Uint8 zeros[4096] = {};
+    for (std::uint64_t silence = audioDropped.exchange(0, std::memory_order_relaxed); silence > 0;) {
+        const std::size_t chunk = static_cast<std::size_t>(std::min<std::uint64_t>(silence, sizeof(zeros)));
+        if (std::fwrite(zeros, 1, chunk, audio) != chunk) audioFailed = true;
+        silence -= chunk;
+        audioWritten += chunk;
+        audioSilence += chunk;
+    }
+}
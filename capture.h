@@ -0,0 +1,119 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "options.h"
+
+// Records the game into video and audio files from inside the game loop.
+//
+// Frames are sampled on a fixed capture clock. Each sample is read back from
+// the renderer into one of a few preallocated buffers and queued to encoder
+// workers. If every buffer is still in use, the frame is dropped and counted
+// instead of making the game wait. Y4M and raw streams stay in time by
+// writing the next frame once for every sample it replaces. PNG frames are
+// numbered by sample, so missing ones show as gaps.
+//
+// The final audio mix is copied into a lock-free ring on the audio thread
+// and written to a WAV file next to the video.
+class GameCapture {
+private:
+    static constexpr int BUFFERS = 8;
+    static constexpr std::size_t AUDIO_RING_BYTES = 1 << 18;  // About 1.5 s of 44.1 kHz stereo
+    static_assert((AUDIO_RING_BYTES & (AUDIO_RING_BYTES - 1)) == 0, "AUDIO_RING_BYTES must be a power of two");
+
+    struct Frame {
+        std::vector<Uint8> pixels;      // ARGB8888 rows as read back
+        std::vector<Uint8> yuv;         // I420 planes for Y4M
+        std::uint64_t index = 0;        // Sample on the capture clock
+        std::uint64_t sequence = 0;     // Order the frames were queued in
+        std::uint64_t repeats = 1;      // Samples this frame fills in a stream
+    };
+
+    CaptureFormat format = CaptureFormat::Y4M;
+    int fps = 60;
+    int width = 0;
+    int height = 0;
+    char basePath[512] = {};
+    std::FILE* video = nullptr;
+    std::FILE* audio = nullptr;
+    bool active = false;
+
+    Frame frames[BUFFERS];
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable frameReady;
+    std::condition_variable writeTurn;
+    Frame* freeFrames[BUFFERS] = {};
+    int freeCount = 0;
+    Frame* readyFrames[BUFFERS] = {};
+    int readyHead = 0;
+    int readyCount = 0;
+    std::uint64_t nextWrite = 0;
+    bool stopping = false;
+    bool writeFailed = false;
+    Uint64 encodeTicks = 0;
+    std::uint64_t encoded = 0;
+
+    // Main thread only.
+    Uint64 startedAt = 0;
+    std::uint64_t queued = 0;
+    std::uint64_t lastIndex = 0;
+    std::uint64_t dropped = 0;
+    std::uint64_t droppedIndex = 0;
+    std::uint64_t pendingDrops = 0;
+    std::uint64_t held = 0;
+    Uint64 captureTicks = 0;
+    Uint64 maxCaptureTicks = 0;
+
+    // Audio ring: pushAudio() is the producer, audioLoop() the consumer.
+    std::unique_ptr<Uint8[]> audioRing;
+    std::atomic<std::size_t> audioHead{0};
+    std::atomic<std::size_t> audioTail{0};
+    std::atomic<std::uint64_t> audioDropped{0};
+    std::atomic<bool> audioEnabled{false};
+    std::atomic<int> audioPushing{0};
+    std::thread audioWriter;
+    std::condition_variable audioWake;
+    bool audioStopping = false;
+    std::uint64_t audioWritten = 0;
+    std::uint64_t audioSilence = 0;
+    bool audioFailed = false;           // Set by the audio writer, read once it has stopped
+    int audioFrequency = 0;
+    int audioChannels = 0;
+
+    void workerLoop();
+    bool encode(Frame& frame);
+    bool writeFrame(const Frame& frame);
+    void audioLoop();
+    void drainAudio();
+    bool openAudio();
+    void closeAudio();
+
+public:
+    GameCapture() = default;
+    ~GameCapture();
+    GameCapture(const GameCapture&) = delete;
+    GameCapture& operator=(const GameCapture&) = delete;
+
+    // Starts a new take in options.captureDir, named after the current time.
+    bool start(SDL_Renderer* renderer, const GameOptions& options);
+    // Waits for the queued frames to be written, closes the files and logs
+    // the overhead of the take.
+    void stop();
+    bool isActive() const { return active; }
+
+    // Main thread, after the frame is composed and before it is presented.
+    void captureFrame(SDL_Renderer* renderer);
+    // Audio thread, with each mixed buffer. Never blocks.
+    void pushAudio(const Uint8* stream, int length);
+};
+
+#endif // CAPTURE_H
@@ -0,0 +1,66 @@
+#include "collisionmask.h"
+#include <algorithm>
+#include "constants.h"
+
+namespace {
+
+// A pipe row in bird coordinates: pipe column p lands on bird column p + shift.
+std::uint64_t shifted(std::uint64_t row, int shift) {
+    if (shift >= 64 || shift <= -64) return 0;
+    return shift >= 0 ? row << shift : row >> -shift;
+}
+
+// Tests bird rows [first, last) against a pipe drawn over screen rows
+// [pipeTop, pipeTop + drawnHeight). Mask rows are picked in 16.16 fixed point
+// so the loop has no division.
+bool rowsOverlap(const CollisionMask& bird, int birdY, int first, int last, const CollisionMask& pipe,
+                 int pipeTop, int drawnHeight, int shift) {
+    if (first >= last || drawnHeight <= 0 || pipe.empty()) return false;
+    const std::uint32_t step = (static_cast<std::uint32_t>(pipe.getHeight()) << 16) / static_cast<std::uint32_t>(drawnHeight);
+    for (int r = first; r < last; r++) {
+        const int pipeRow = std::min(static_cast<int>((static_cast<std::uint32_t>(birdY + r - pipeTop) * step) >> 16),
+                                     pipe.getHeight() - 1);
+        if (bird.row(r) & shifted(pipe.row(pipeRow), shift)) return true;
+    }
+    return false;
+}
+
+}
+
+bool CollisionMask::build(const std::uint32_t* pixels, int imageW, int imageH, int pitchPixels,
+                          int width, int height, std::uint8_t threshold) {
+    if (width <= 0 || height <= 0 || width > MAX_WIDTH || imageW <= 0 || imageH <= 0) return false;
+    this->width = width;
+    this->height = height;
+    rows.assign(height, 0);
+    for (int r = 0; r < height; r++) {
+        const std::uint32_t* line = pixels + static_cast<long long>(r) * imageH / height * pitchPixels;
+        std::uint64_t bits = 0;
+        for (int c = 0; c < width; c++) {
+            const std::uint32_t pixel = line[static_cast<long long>(c) * imageW / width];
+            if ((pixel >> 24) >= threshold) bits |= std::uint64_t(1) << c;
+        }
+        rows[r] = bits;
+    }
+    firstSolid = height;
+    lastSolid = 0;
+    for (int r = 0; r < height; r++) {
+        if (!rows[r]) continue;
+        firstSolid = std::min(firstSolid, r);
+        lastSolid = r + 1;
+    }
+    return true;
+}
+
+bool pixelsOverlap(const CollisionMask& bird, int birdX, int birdY, const CollisionMasks& masks,
+                   int pipeX, int gapTop, int gapBottom) {
+    if (bird.empty()) return true;
+    const int shift = pipeX - birdX;
+    // Only solid bird rows above or below the gap can touch a pipe.
+    const int first = bird.getFirstSolidRow();
+    const int last = bird.getLastSolidRow();
+    const int aboveGap = std::clamp(gapTop - birdY, first, last);
+    const int belowGap = std::clamp(gapBottom - birdY, first, last);
+    return rowsOverlap(bird, birdY, first, aboveGap, masks.pipeFlipped, 0, gapTop, shift) ||
+           rowsOverlap(bird, birdY, belowGap, last, masks.pipe, gapBottom, Constants::WINDOW_HEIGHT - gapBottom, shift);
+}
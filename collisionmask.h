@@ -0,0 +1,51 @@
+#ifndef COLLISIONMASK_H
+#define COLLISIONMASK_H
+
+#include <cstdint>
+#include <vector>
+
+// Opaque pixels of a sprite, one 64-bit word per row: bit c is column c from
+// the left. Built once at load time; testing two masks is a shift and an AND
+// per row.
+class CollisionMask {
+public:
+    static constexpr int MAX_WIDTH = 64;
+
+private:
+    int width = 0;
+    int height = 0;
+    int firstSolid = 0;     // Rows outside [firstSolid, lastSolid) are empty
+    int lastSolid = 0;
+    std::vector<std::uint64_t> rows;
+
+public:
+    // Samples an ARGB8888 image to width x height by nearest neighbour.
+    // Pixels with alpha >= threshold are solid. Returns false if width is
+    // over MAX_WIDTH or either size is not positive.
+    bool build(const std::uint32_t* pixels, int imageW, int imageH, int pitchPixels,
+               int width, int height, std::uint8_t threshold = 128);
+
+    bool empty() const { return rows.empty(); }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getFirstSolidRow() const { return firstSolid; }
+    int getLastSolidRow() const { return lastSolid; }
+    std::uint64_t row(int r) const { return rows[r]; }
+};
+
+// Masks the simulation refines bounding box hits with. Pipes are stretched
+// to their drawn height, so their masks keep the image's own row count and
+// are sampled per screen row.
+struct CollisionMasks {
+    CollisionMask birds[2];     // Chim người chơi 1 và 2, BIRD_SIZE x BIRD_SIZE
+    CollisionMask pipe;         // Ống dưới, rộng PIPE_WIDTH
+    CollisionMask pipeFlipped;  // Ống trên (ảnh ống quay 180 độ)
+};
+
+// Narrow phase for a bird whose box overlaps the pipe pair at pipeX with the
+// gap [gapTop, gapBottom). birdY is the integer y the box test used.
+// Returns true if an opaque bird pixel covers an opaque pipe pixel.
+bool pixelsOverlap(const CollisionMask& bird, int birdX, int birdY, const CollisionMasks& masks,
+                   int pipeX, int gapTop, int gapBottom);
+
+#endif // COLLISIONMASK_H
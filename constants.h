@@ -9,6 +9,20 @@ namespace Constants {
     constexpr int PIPE_GAP = 150;       // Gap between top and bottom pipes
     constexpr int PIPE_SPACING = 120;   // Spacing between pipe pairs
     constexpr int BIRD_SPACING = 80;    // Spacing between birds in 2-player mode
+    constexpr int BIRD_COLUMNS = 2;     // Distinct bird x positions; larger flocks share them
+    constexpr float GRAVITY = 0.4f;         // Velocity added to a bird every tick
+    constexpr float FLAP_VELOCITY = -8.0f;  // Velocity set by a flap
+    constexpr int PIPE_SPEED = 2;           // Pixels a pipe moves left every tick
+    // Most pipes on screen at once: one per PIPE_SPACING + PIPE_WIDTH across the window
+    // plus the one leaving on the left, rounded up to a power of two for the ring buffer.
+    constexpr int PIPE_CAPACITY = 8;
+    static_assert(PIPE_CAPACITY >= (WINDOW_WIDTH + PIPE_WIDTH) / (PIPE_SPACING + PIPE_WIDTH) + 2,
+                  "PIPE_CAPACITY is too small for the window");
+    constexpr int TICK_RATE = 60;           // Simulation ticks per second
+    constexpr int MAX_TICKS_PER_FRAME = 5;  // Ticks run at most per frame before the game slows down
+    constexpr int SUB_TICK_STEPS = 256;     // Resolution of a flap's time within its tick
+    constexpr int AUDIO_FREQUENCY = 44100;  // Mixer output rate; bundled sound effects are stored at it
+    constexpr int AUDIO_CHANNELS = 2;       // Mixer output channels
 }
 
 #endif // CONSTANTS_H
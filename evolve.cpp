@@ -0,0 +1,55 @@
+#include "neuroevolution.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+// Evolves MLP autopilots headless and writes the best network found.
+// Usage: evolve [population] [generations] [seed] [output genome]
+// Also reports how long policy inference takes per tick for the population,
+// against the 60 fps frame budget.
+
+int main(int argc, char* argv[]) {
+    using Clock = std::chrono::steady_clock;
+    const int population = argc > 1 ? std::atoi(argv[1]) : 1000;
+    const int generations = argc > 2 ? std::atoi(argv[2]) : 50;
+    const unsigned seed = argc > 3 ? static_cast<unsigned>(std::strtoul(argv[3], nullptr, 10)) : 1u;
+    const char* output = argc > 4 ? argv[4] : "best.mlp";
+    if (population <= 0 || generations <= 0) {
+        std::fprintf(stderr, "Usage: %s [population] [generations] [seed] [output genome]\n", argv[0]);
+        return 1;
+    }
+
+    Evolution evolution(seed);
+    Simulation simulation;
+    evolution.start(population);
+    double inferenceSeconds = 0.0;
+    double slowestTick = 0.0;
+    long long ticks = 0;
+    for (int generation = 0; generation < generations; generation++) {
+        evolution.beginGeneration(simulation);
+        while (!evolution.generationOver(simulation)) {
+            const Clock::time_point begin = Clock::now();
+            evolution.act(simulation);
+            const double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+            inferenceSeconds += elapsed;
+            slowestTick = std::max(slowestTick, elapsed);
+            ticks++;
+            simulation.step();
+            simulation.clearEvents();
+            evolution.observe(simulation);
+        }
+        evolution.evolve(simulation);
+        std::printf("generation %3d: best %6.0f ticks, mean %8.1f ticks, best score %d\n", generation,
+                    evolution.getLastBestFitness(), evolution.getLastMeanFitness(), evolution.getLastBestScore());
+    }
+
+    std::printf("policy inference for %d birds: %.3f ms per tick on average, %.3f ms at worst (frame budget %.1f ms)\n",
+                population, inferenceSeconds * 1000.0 / ticks, slowestTick * 1000.0, 1000.0 / Constants::TICK_RATE);
+    if (!saveGenome(output, evolution.getBestGenome())) {
+        std::fprintf(stderr, "Cannot write %s\n", output);
+        return 1;
+    }
+    std::printf("wrote the best network to %s\n", output);
+    return 0;
+}
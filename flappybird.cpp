@@ -1,298 +1,375 @@
 #include "flappybird.h"
+#include "assets.h"
 #include <algorithm>
-#include <cstdlib>
+#include <cstdio>
 #include <ctime>
-#include <fstream>
-#include <iostream>
 
-FlappyBird::FlappyBird() {
-    if (!initSDL() || !setupWindowAndRenderer() || !loadFontResources() ||
-        !loadTextureResources() || !loadAudioResources()) {
+#ifdef FLAPPY_COUNT_ALLOCS
+#include <cstdlib>
+#include "alloccounter.h"
+#endif
+
+namespace {
+
+const char* const INFO_LINES[] = {
+    "This game is based on the original",
+    "Flappy Bird by Nguyen Quang Dong.",
+    "Your duty is to make the bird fly",
+    "through pipes as far as possible.",
+    "New mode: 2 players! Player 1 is the",
+    "yellow bird using the SPACE button,",
+    "Player 2 is the green bird using",
+    "UP or DOWN/LEFT/RIGHT buttons.",
+    "Having fun!",
+    "-Truong-"
+};
+
+const Sprite MENU_SPRITES[] = {Sprite::BACKGROUND, Sprite::LOGO, Sprite::SPEAKER_ON, Sprite::SPEAKER_OFF};
+const Sprite GAMEPLAY_SPRITES[] = {Sprite::PIPE, Sprite::PIPE_FLIPPED, Sprite::PLAYER1, Sprite::PLAYER2};
+
+const Sound GAMEPLAY_SOUNDS[] = {Sound::DIE, Sound::HIT, Sound::POINT, Sound::WING, Sound::FALLING};
+
+const char* const SCORE_JOURNAL_FILE = "scores.journal";
+const char* const LEADERBOARD_FILE = "leaderboard.dat";
+// Written by earlier versions; its score seeds a new journal.
+const char* const LEGACY_HIGH_SCORE_FILE = "highscore.txt";
+
+// Longest a static screen sleeps without events before polling for assets again.
+constexpr Uint32 IDLE_TIMEOUT_MS = 250;
+
+// SDL2 stamps events in milliseconds of SDL_GetTicks(). The stamp is moved onto
+// the clock the simulation thread schedules ticks with, at millisecond precision.
+std::uint64_t eventClockNs(Uint32 eventTicks) {
+    const Uint32 age = SDL_GetTicks() - eventTicks;
+    return simClockNs() - static_cast<std::uint64_t>(age) * 1000000;
+}
+
+// Effect played for each SimEventType.
+const Sound EVENT_SOUNDS[SIM_EVENT_TYPES] = {Sound::WING, Sound::HIT, Sound::FALLING, Sound::DIE, Sound::POINT};
+
+}
+
+FlappyBird::FlappyBird(const GameOptions& gameOptions) : options(gameOptions) {
+    // Static screens are not redrawn, so a capture could not sample them.
+    if (options.captureDir) options.idleMode = false;
+    if (!initSDL() || !setupWindowAndRenderer()) {
+        cleanup();
+        return;
+    }
+    startAssetLoading();
+    if (!loadFontResources() || !loadTextureResources() || !loadAudioResources()) {
         cleanup();
         return;
     }
-    std::srand(static_cast<unsigned>(std::time(nullptr)));
+    layoutWidgets();
+    mixer.attach(sounds);
+    SDL_Log("Menu ready after %.1f ms", assetLoader.elapsedMs());
+    seedSource.seed(static_cast<unsigned>(std::time(nullptr)));
     running = true;
-    highScore = loadHighScore();
+    loadScores();
     setupMenu();
     if (lobbyMusic) {
         Mix_VolumeMusic(MIX_MAX_VOLUME);
         Mix_PlayMusic(lobbyMusic, -1);
     }
+    if (options.policyFile) {
+        aiGenome.resize(NeuralPolicy::PARAMETERS);
+        if (!loadGenome(options.policyFile, aiGenome.data())) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot read policy %s", options.policyFile);
+            aiGenome.clear();
+        }
+    }
+    if (options.autopilotUs > 0) simThread.setAutopilot(options.autopilotUs);
+    if (options.replayFile) startReplay();
+    Profiler::setEnabled(options.traceFile != nullptr);
+    if (options.telemetryName && !telemetry.open(options.telemetryName))
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot publish telemetry as %s", options.telemetryName);
+    mixer.setCapture(&capture);
+    toggleCapture();
 }
 
 FlappyBird::~FlappyBird() {
-    saveHighScore();
+    dumpTrace();
+    capture.stop();
+    mixer.logStats();
+    logPresentLatency();
+    closeScores();
     cleanup();
 }
 
 void FlappyBird::cleanup() {
-    for (auto& [_, texture] : textCache) SDL_DestroyTexture(texture);
-    for (auto& [_, texture] : scoreTextCache) SDL_DestroyTexture(texture);
-    for (auto& [_, texture] : infoTextCache) SDL_DestroyTexture(texture);
-    SDL_DestroyTexture(player1Texture);
-    SDL_DestroyTexture(player2Texture);
-    SDL_DestroyTexture(backgroundTexture);
-    SDL_DestroyTexture(logoTexture);
-    SDL_DestroyTexture(pipeTexture);
-    SDL_DestroyTexture(speakerOnTexture);
-    SDL_DestroyTexture(speakerOffTexture);
+    discardPendingAssets();
+    textAtlas.destroy();
+    menuAtlas.destroy();
+    gameplayAtlas.destroy();
+    if (screenCache) SDL_DestroyTexture(screenCache);
     TTF_CloseFont(font);
+    if (infoFont != scoreFont) TTF_CloseFont(infoFont);
     TTF_CloseFont(scoreFont);
-    TTF_CloseFont(infoFont);
+    TTF_CloseFont(hudFont);
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
-    Mix_FreeChunk(sfx_die);
-    Mix_FreeChunk(sfx_hit);
-    Mix_FreeChunk(sfx_point);
-    Mix_FreeChunk(sfx_wing);
-    Mix_FreeChunk(clickSound);
-    Mix_FreeChunk(sfx_falling);
+    for (Mix_Chunk* sound : sounds) Mix_FreeChunk(sound);
     Mix_FreeMusic(lobbyMusic);
     Mix_FreeMusic(playingMusic);
-    delete soundButton;
-    Mix_CloseAudio();
+    mixer.close();
     Mix_Quit();
     IMG_Quit();
     TTF_Quit();
     SDL_Quit();
 }
 
-SDL_Texture* FlappyBird::createTextTexture(const std::string& text, TTF_Font* targetFont,
-                                         std::unordered_map<std::string, SDL_Texture*>& cache,
-                                         bool isRed) {
-    const std::string key = text + (isRed ? "_red" : "");
-    if (auto it = cache.find(key); it != cache.end()) return it->second;
-
-    const SDL_Color color = isRed ? SDL_Color{255, 0, 0, 255} : SDL_Color{255, 255, 0, 255};
-    const SDL_Color outlineColor = {0, 0, 0, 255};
-
-    TTF_SetFontOutline(targetFont, 2);
-    SDL_Surface* outlineSurface = TTF_RenderText_Blended(targetFont, text.c_str(), outlineColor);
-    TTF_SetFontOutline(targetFont, 0);
-    SDL_Surface* textSurface = TTF_RenderText_Blended(targetFont, text.c_str(), color);
-
-    if (!outlineSurface || !textSurface) {
-        SDL_FreeSurface(outlineSurface);
-        SDL_FreeSurface(textSurface);
-        return nullptr;
-    }
-
-    SDL_Surface* combinedSurface = SDL_CreateRGBSurface(0, outlineSurface->w, outlineSurface->h, 32,
-        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
-
-    SDL_BlitSurface(outlineSurface, nullptr, combinedSurface, nullptr);
-    SDL_Rect offset = {(combinedSurface->w - textSurface->w) / 2,
-                      (combinedSurface->h - textSurface->h) / 2, 0, 0};
-    SDL_BlitSurface(textSurface, nullptr, combinedSurface, &offset);
-
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, combinedSurface);
-    if (texture) cache[key] = texture;
-
-    SDL_FreeSurface(outlineSurface);
-    SDL_FreeSurface(textSurface);
-    SDL_FreeSurface(combinedSurface);
-    return texture;
-}
-
-void FlappyBird::renderText(const std::string& text, int x, int y, bool center,
+void FlappyBird::renderText(std::string_view text, int x, int y, bool center,
                            bool isScore, bool isInfo, bool isRed) {
-    TTF_Font* targetFont = isScore ? scoreFont : (isInfo ? infoFont : font);
-    auto& targetCache = isScore ? scoreTextCache : (isInfo ? infoTextCache : textCache);
-    SDL_Texture* texture = createTextTexture(text, targetFont, targetCache, isRed);
-    if (!texture) return;
-
+    PROFILE_ZONE("renderText");
+    const TextStyle style = isScore ? TextStyle::SCORE
+                          : isInfo ? (isRed ? TextStyle::INFO_RED : TextStyle::INFO)
+                          : TextStyle::TITLE;
     int w, h;
-    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
-    SDL_Rect rect = {center ? x - w / 2 : x, y, w, h};
-    SDL_RenderCopy(renderer, texture, nullptr, &rect);
-}
-
-bool FlappyBird::isPointInRect(int x, int y, const SDL_Rect& rect) const {
-    return x >= rect.x && x <= rect.x + rect.w && y >= rect.y && y <= rect.y + rect.h;
-}
-
-SDL_Texture* FlappyBird::loadTexture(const char* file) {
-    SDL_Surface* surface = IMG_Load(file);
-    if (!surface) return nullptr;
-    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-    SDL_FreeSurface(surface);
-    return texture;
+    textAtlas.measureText(style, text, w, h);
+    textAtlas.drawText(renderBatch, style, text, center ? x - w / 2 : x, y);
 }
 
 bool FlappyBird::initSDL() {
     return SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) >= 0 &&
            TTF_Init() >= 0 &&
            IMG_Init(IMG_INIT_PNG) != 0 &&
-           Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) >= 0;
+           mixer.open(options.audioBufferSamples);
 }
 
 bool FlappyBird::setupWindowAndRenderer() {
     window = SDL_CreateWindow("Flappy Bird", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                             Constants::WINDOW_WIDTH, Constants::WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
     if (!window) return false;
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 rendererFlags = SDL_RENDERER_ACCELERATED;
+    if (options.frameMode == FrameMode::VSYNC) rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
+    renderer = SDL_CreateRenderer(window, -1, rendererFlags);
     if (!renderer) {
         SDL_DestroyWindow(window);
         window = nullptr;
         return false;
     }
+    // Without render targets every static frame is composed straight to the window instead.
+    if (options.idleMode && SDL_RenderTargetSupported(renderer))
+        screenCache = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+                                        Constants::WINDOW_WIDTH, Constants::WINDOW_HEIGHT);
     return true;
 }
 
 bool FlappyBird::loadFontResources() {
-    font = TTF_OpenFont("font/SVN-New Athletic M54.ttf", 48);
-    scoreFont = TTF_OpenFont("font/SVN-New Athletic M54.ttf", 24);
-    infoFont = TTF_OpenFont("font/SVN-New Athletic M54.ttf", 24);
-    return font && scoreFont && infoFont;
+    const Uint64 start = SDL_GetPerformanceCounter();
+    font = assetLoader.openFont(48);
+    scoreFont = assetLoader.openFont(24);
+    // Score and info text use the same face and size, so they share one font.
+    infoFont = scoreFont;
+    hudFont = assetLoader.openFont(12);
+    if (!font || !scoreFont || !infoFont || !hudFont) return false;
+
+    TTF_Font* const styleFonts[] = {font, scoreFont, infoFont, infoFont, hudFont};
+    const SDL_Color styleColors[] = {{255, 255, 0, 255}, {255, 255, 0, 255}, {255, 255, 0, 255}, {255, 0, 0, 255},
+                                     {255, 255, 255, 255}};
+    const bool built = textAtlas.build(renderer, styleFonts, styleColors);
+    SDL_Log("Opened fonts and baked glyph atlas in %.2f ms",
+            static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    return built;
+}
+
+void FlappyBird::startAssetLoading() {
+    // Anything the bundle provides is ready immediately; the rest is decoded
+    // from loose files, menu assets first.
+    assetLoader.openBundle(Assets::BUNDLE);
+    for (Sprite sprite : MENU_SPRITES)
+        pendingSprites[static_cast<int>(sprite)] = assetLoader.loadSprite(sprite);
+    pendingSounds[static_cast<int>(Sound::CLICK)] = assetLoader.loadChunk(Sound::CLICK);
+    pendingLobbyMusic = assetLoader.loadMusic(Music::LOBBY);
+
+    for (Sprite sprite : GAMEPLAY_SPRITES)
+        pendingSprites[static_cast<int>(sprite)] = assetLoader.loadSprite(sprite);
+    for (Sound sound : GAMEPLAY_SOUNDS)
+        pendingSounds[static_cast<int>(sound)] = assetLoader.loadChunk(sound);
+    pendingPlayingMusic = assetLoader.loadMusic(Music::PLAYING);
 }
 
 bool FlappyBird::loadTextureResources() {
-    player1Texture = loadTexture("picture/player1.png");
-    player2Texture = loadTexture("picture/player2.png");
-    backgroundTexture = loadTexture("picture/background_and_road.png");
-    logoTexture = loadTexture("picture/logo.png");
-    pipeTexture = loadTexture("picture/pipe.png");
-    speakerOnTexture = loadTexture("picture/speaker_on.png");
-    speakerOffTexture = loadTexture("picture/speaker_off.png");
-    return player1Texture && player2Texture && backgroundTexture &&
-           logoTexture && pipeTexture && speakerOnTexture && speakerOffTexture;
+    SDL_Surface* surfaces[SDL_arraysize(MENU_SPRITES)];
+    for (size_t i = 0; i < SDL_arraysize(MENU_SPRITES); i++)
+        surfaces[i] = pendingSprites[static_cast<int>(MENU_SPRITES[i])].get();
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const bool built = menuAtlas.build(renderer, MENU_SPRITES, surfaces, SDL_arraysize(MENU_SPRITES));
+    SDL_Log("Uploaded menu sprite atlas in %.2f ms",
+            static_cast<double>(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    return built;
 }
 
 bool FlappyBird::loadAudioResources() {
-    sfx_die = Mix_LoadWAV("sound/sfx_die.wav");
-    sfx_hit = Mix_LoadWAV("sound/sfx_hit.wav");
-    sfx_point = Mix_LoadWAV("sound/sfx_point.wav");
-    sfx_wing = Mix_LoadWAV("sound/sfx_wing.wav");
-    clickSound = Mix_LoadWAV("sound/clicking.wav");
-    sfx_falling = Mix_LoadWAV("sound/falling.wav");
-    lobbyMusic = Mix_LoadMUS("sound/sound at lobby.mp3");
-    playingMusic = Mix_LoadMUS("sound/sound effect while playing.mp3");
-    return sfx_die && sfx_hit && sfx_point && sfx_wing &&
-           clickSound && sfx_falling && lobbyMusic && playingMusic;
+    sounds[static_cast<int>(Sound::CLICK)] = pendingSounds[static_cast<int>(Sound::CLICK)].get();
+    lobbyMusic = pendingLobbyMusic.get();
+    return sounds[static_cast<int>(Sound::CLICK)] && lobbyMusic;
+}
+
+bool FlappyBird::loadGameplayAssets(bool wait) {
+    if (gameplayAssetsLoaded) return true;
+    if (!wait) {
+        for (Sprite sprite : GAMEPLAY_SPRITES)
+            if (!AssetLoader::isReady(pendingSprites[static_cast<int>(sprite)])) return false;
+        for (Sound sound : GAMEPLAY_SOUNDS)
+            if (!AssetLoader::isReady(pendingSounds[static_cast<int>(sound)])) return false;
+        if (!AssetLoader::isReady(pendingPlayingMusic)) return false;
+    }
+
+    SDL_Surface* surfaces[SDL_arraysize(GAMEPLAY_SPRITES)];
+    SDL_Surface* spriteSurfaces[static_cast<int>(Sprite::COUNT)] = {};
+    for (size_t i = 0; i < SDL_arraysize(GAMEPLAY_SPRITES); i++) {
+        surfaces[i] = pendingSprites[static_cast<int>(GAMEPLAY_SPRITES[i])].get();
+        spriteSurfaces[static_cast<int>(GAMEPLAY_SPRITES[i])] = surfaces[i];
+    }
+    // The atlas frees the surfaces, so the masks are taken first.
+    pixelCollision = SpriteAtlas::collisionMasks(spriteSurfaces, collisionMasks);
+    if (!pixelCollision) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "No collision masks, using box collision");
+    bool ok = gameplayAtlas.build(renderer, GAMEPLAY_SPRITES, surfaces, SDL_arraysize(GAMEPLAY_SPRITES));
+    for (Sound sound : GAMEPLAY_SOUNDS) {
+        sounds[static_cast<int>(sound)] = pendingSounds[static_cast<int>(sound)].get();
+        ok = ok && sounds[static_cast<int>(sound)];
+    }
+    playingMusic = pendingPlayingMusic.get();
+    ok = ok && playingMusic;
+
+    SDL_Log("Gameplay assets ready after %.1f ms%s", assetLoader.elapsedMs(), wait ? " (waited)" : "");
+    if (!ok) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load gameplay assets");
+        running = false;
+    }
+    gameplayAssetsLoaded = ok;
+    return ok;
+}
+
+void FlappyBird::discardPendingAssets() {
+    assetLoader.waitIdle();
+    for (auto& pending : pendingSprites)
+        if (pending.valid()) SDL_FreeSurface(pending.get());
+    for (auto& pending : pendingSounds)
+        if (pending.valid()) Mix_FreeChunk(pending.get());
+    if (pendingLobbyMusic.valid()) Mix_FreeMusic(pendingLobbyMusic.get());
+    if (pendingPlayingMusic.valid()) Mix_FreeMusic(pendingPlayingMusic.get());
+}
+
+void FlappyBird::drawSprite(Sprite sprite, const SDL_FRect& dst) {
+    (gameplayAtlas.contains(sprite) ? gameplayAtlas : menuAtlas).draw(renderBatch, sprite, dst);
+}
+
+void FlappyBird::playSound(Sound sound) {
+    mixer.queue(sound);
+    mixer.flush();
 }
 
 void FlappyBird::setupMenu() {
-    buttons.clear();
-    const int centerX = Constants::WINDOW_WIDTH / 2 - 100;
-    buttons.emplace_back(centerX, Constants::WINDOW_HEIGHT / 2 - 60, 200, 30, "1 Player");
-    buttons.emplace_back(centerX, Constants::WINDOW_HEIGHT / 2, 200, 30, "2 Players");
-    buttons.emplace_back(centerX, Constants::WINDOW_HEIGHT / 2 + 60, 200, 30, "Information");
-    soundButton = new Button(Constants::WINDOW_WIDTH - 50, 10, 40, 40, "");
+    widgets.setScreen(UiScreen::MENU);
 }
 
-void FlappyBird::handleButtonHover(int x, int y, Button& button, float scaleFactor) {
-    SDL_Texture* texture = createTextTexture(button.text, font, textCache, button.isRed);
+void FlappyBird::addButton(UiScreen screen, Button button) {
+    // Hover is tested against the text measured in the title font, as it always was;
+    // drawing uses the button's own style.
     int w, h;
-    SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
-    SDL_Rect textRect = {button.rect.x + (button.rect.w - w) / 2,
-                       button.rect.y + (button.rect.h - h) / 2, w, h};
-
-    if (isPointInRect(x, y, textRect)) {
-        if (!button.hovered) {
-            button.hovered = true;
-            button.rect.w = static_cast<int>(button.originalW * scaleFactor);
-            button.rect.h = static_cast<int>(button.originalH * scaleFactor);
-            button.rect.x -= (button.rect.w - button.originalW) / 2;
-            button.rect.y -= (button.rect.h - button.originalH) / 2;
-        }
-    } else if (button.hovered) {
-        button.hovered = false;
-        button.rect.w = button.originalW;
-        button.rect.h = button.originalH;
-        button.rect.x += (static_cast<int>(button.originalW * scaleFactor) - button.originalW) / 2;
-        button.rect.y += (static_cast<int>(button.originalH * scaleFactor) - button.originalH) / 2;
-    }
-}
-
-void FlappyBird::updateBirdPhysics() {
-    for (auto& bird : birds) {
-        bird.velocity += 0.4f;
-        bird.y += bird.velocity;
-        //frameCounter++;
-        //if (frameCounter >= 30) {
-            //std::cout << "Bird position - Y: " << bird.y << ", Velocity: " << bird.velocity << std::endl;
-            //frameCounter = 0; // Đặt lại đếm sau khi in
-        //}
-
-        if (bird.y + Constants::BIRD_SIZE >= Constants::WINDOW_HEIGHT) {
-            if (bird.collided) bird.alive = false;
-            else if (bird.alive) {
-                Mix_PlayChannel(-1, sfx_falling, 0);
-                bird.alive = false;
-            }
-        }
-        if (bird.y < 0) {
-            bird.y = 0;
-            bird.velocity = 0;
-        }
-    }
+    textAtlas.measureText(TextStyle::TITLE, button.text, w, h);
+    button.hoverRect = {button.rect.x + (button.rect.w - w) / 2, button.rect.y + (button.rect.h - h) / 2, w, h};
+    textAtlas.measureText(button.isRed ? TextStyle::INFO_RED : TextStyle::TITLE, button.text, button.textW, button.textH);
+    widgets.add(screen, button);
 }
 
-void FlappyBird::updatePipes() {
-    for (auto it = pipes.begin(); it != pipes.end();) {
-        it->x -= 2;
-        for (size_t i = 0; i < birds.size(); i++) {
-            if (!birds[i].alive) continue;
-            int birdX = Constants::WINDOW_WIDTH / 4 + static_cast<int>(i * Constants::BIRD_SPACING);
-            SDL_Rect birdRect = {birdX, static_cast<int>(birds[i].y), Constants::BIRD_SIZE, Constants::BIRD_SIZE};
-            SDL_Rect topPipe = {it->x, 0, Constants::PIPE_WIDTH, it->gapY - Constants::PIPE_GAP / 2};
-            SDL_Rect bottomPipe = {it->x, it->gapY + Constants::PIPE_GAP / 2, Constants::PIPE_WIDTH,
-                                 Constants::WINDOW_HEIGHT - (it->gapY + Constants::PIPE_GAP / 2)};
+void FlappyBird::layoutWidgets() {
+    const int centerX = Constants::WINDOW_WIDTH / 2 - 100;
+    addButton(UiScreen::MENU, Button(Constants::WINDOW_WIDTH - 50, 10, 40, 40, "", ButtonAction::TOGGLE_SOUND, 1.2f));
+    addButton(UiScreen::MENU, Button(centerX, Constants::WINDOW_HEIGHT / 2 - 60, 200, 30, "1 Player", ButtonAction::ONE_PLAYER, 5.0f));
+    addButton(UiScreen::MENU, Button(centerX, Constants::WINDOW_HEIGHT / 2, 200, 30, "2 Players", ButtonAction::TWO_PLAYERS, 5.0f));
+    addButton(UiScreen::MENU, Button(centerX, Constants::WINDOW_HEIGHT / 2 + 60, 200, 30, "Information", ButtonAction::INFORMATION, 5.0f));
+    addButton(UiScreen::MENU, Button(centerX, Constants::WINDOW_HEIGHT / 2 + 120, 200, 30, "AI Birds", ButtonAction::AI_BIRDS, 5.0f));
 
-            if ((SDL_HasIntersection(&birdRect, &topPipe) || SDL_HasIntersection(&birdRect, &bottomPipe)) &&
-                !birds[i].collided) {
-                birds[i].collided = true;
-                Mix_PlayChannel(-1, sfx_hit, 0);
-            }
-        }
+    int truongW, truongH;
+    textAtlas.measureText(TextStyle::INFO, "-Truong-", truongW, truongH);
+    addButton(UiScreen::INFO, Button((Constants::WINDOW_WIDTH - truongW) / 2, Constants::WINDOW_HEIGHT - 60, truongW, 30,
+                                     "Return", ButtonAction::RETURN_TO_MENU, 5.0f, true));
 
-        if (it->x + Constants::PIPE_WIDTH < Constants::WINDOW_WIDTH / 4 &&
-            it->x + Constants::PIPE_WIDTH >= Constants::WINDOW_WIDTH / 4 - 2) {
-            for (auto& bird : birds) {
-                if (bird.alive) {
-                    bird.score++;
-                    Mix_PlayChannel(-1, sfx_point, 0);
-                }
-            }
-        }
-        it = (it->x + Constants::PIPE_WIDTH < 0) ? pipes.erase(it) : std::next(it);
-    }
+    addButton(UiScreen::RETURN_TO_MENU, Button(Constants::WINDOW_WIDTH / 2 - 140, Constants::WINDOW_HEIGHT - 60, 280, 30,
+                                               "Return to Menu", ButtonAction::RETURN_TO_MENU, 5.0f, true));
+    if (!widgets.finishLayout()) SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Too many widgets in one hit grid cell");
 }
 
-void FlappyBird::spawnPipe() {
-    if (pipes.empty() || (Constants::WINDOW_WIDTH - pipes.back().x >= Constants::PIPE_SPACING + Constants::PIPE_WIDTH)) {
-        int gapY = rand() % (Constants::WINDOW_HEIGHT - Constants::PIPE_GAP - 150) + 75;
-        pipes.emplace_back(Constants::WINDOW_WIDTH, gapY);
-    }
+const SimSnapshot* FlappyBird::currentSnapshot() const {
+    const SimSnapshot& snapshot = simThread.snapshot();
+    return snapshot.generation == simGeneration ? &snapshot : nullptr;
 }
 
-int FlappyBird::loadHighScore() {
-    std::ifstream file(HIGH_SCORE_FILE);
-    int score = 0;
-    if (file.is_open()) {
-        file >> score;
-        file.close();
+void FlappyBird::pollSimulation() {
+    PROFILE_ZONE("pollSimulation");
+    if (!simThread.poll()) return;
+    const SimSnapshot* snapshot = currentSnapshot();
+    if (!snapshot) return;
+    if (snapshot->generation != seenGeneration) {
+        seenGeneration = snapshot->generation;
+        std::fill(seenEvents, seenEvents + SIM_EVENT_TYPES, 0);
     }
-    return score;
-}
+    // Several ticks may have passed since the last snapshot; identical effects are merged by the mixer.
+    for (int i = 0; i < SIM_EVENT_TYPES; i++) {
+        if (snapshot->events[i] != seenEvents[i])
+            mixer.queue(EVENT_SOUNDS[i], static_cast<int>(snapshot->events[i] - seenEvents[i]));
+        seenEvents[i] = snapshot->events[i];
+    }
+    mixer.flush();
 
-void FlappyBird::saveHighScore() {
-    std::ofstream file(HIGH_SCORE_FILE);
-    if (file.is_open()) {
-        file << highScore;
-        file.close();
+    // A networked game offers the way back to the menu until every player is connected.
+    if (netGame && snapshot->started && !showGameOver && widgets.getScreen() == UiScreen::RETURN_TO_MENU)
+        widgets.setScreen(UiScreen::NONE);
+    const bool playing = gameState == GameState::ONE_PLAYER || gameState == GameState::TWO_PLAYER;
+    if (playing && snapshot->over && !showGameOver) {
+        updateGameOver();
+        finishRecording();
+        // A flap that shows up with the final frame is left out of this game's
+        // latency rather than counted towards the next one.
+        presentedInputAt = std::max(presentedInputAt, snapshot->inputAt);
+        logPresentLatency();
+        showGameOver = true;
+        widgets.setScreen(UiScreen::RETURN_TO_MENU);
     }
 }
 
+void FlappyBird::loadScores() {
+    scoreJournal.open(SCORE_JOURNAL_FILE, LEADERBOARD_FILE, LEGACY_HIGH_SCORE_FILE);
+    const ScoreJournal::Recovery& recovery = scoreJournal.getRecovery();
+    SDL_Log("Loaded %d leaderboard runs from %u journal records (%u replayed) in %.2f ms%s", recovery.entries,
+            recovery.records, recovery.replayed, recovery.ms, recovery.imported ? ", high score taken over" : "");
+    highScore = scoreJournal.getLeaderboard().bestScore();
+}
+
+void FlappyBird::closeScores() {
+    scoreJournal.close();
+    if (scoreJournal.getDroppedRuns() > 0)
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%d runs finished faster than the journal could take them",
+                     scoreJournal.getDroppedRuns());
+    if (scoreJournal.getWriteFailures() > 0)
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%d writes to %s or %s failed", scoreJournal.getWriteFailures(),
+                     SCORE_JOURNAL_FILE, LEADERBOARD_FILE);
+}
+
 void FlappyBird::handleInput() {
+    PROFILE_ZONE("handleInput");
+    // Only the last motion of a batch matters for hover, so earlier ones are
+    // dropped. A pending motion is applied before any click so the click sees
+    // the hover state at its own position.
+    bool motionPending = false;
+    int motionX = 0, motionY = 0;
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
+        if (motionPending && event.type != SDL_MOUSEMOTION) {
+            handleMouseMotion(motionX, motionY);
+            motionPending = false;
+        }
         switch (event.type) {
             case SDL_QUIT:
                 running = false;
                 break;
             case SDL_KEYDOWN:
+                lastInputTicks = event.key.timestamp;
+                lastInputAt = eventClockNs(event.key.timestamp);
                 handleKeyDown(event.key.keysym.sym);
                 break;
             case SDL_MOUSEBUTTONDOWN:
@@ -300,90 +377,100 @@ void FlappyBird::handleInput() {
                     handleMouseClick(event.button.x, event.button.y);
                 break;
             case SDL_MOUSEMOTION:
-                handleMouseMotion(event.motion.x, event.motion.y);
+                motionPending = true;
+                motionX = event.motion.x;
+                motionY = event.motion.y;
+                break;
+            case SDL_WINDOWEVENT:
+            case SDL_RENDER_TARGETS_RESET:
+            case SDL_RENDER_DEVICE_RESET:
+                // The window contents or the cached frame may have been lost.
+                screenDirty = true;
                 break;
         }
     }
+    if (motionPending) handleMouseMotion(motionX, motionY);
+    mixer.flush();
 }
 
 void FlappyBird::handleKeyDown(SDL_Keycode key) {
+    screenDirty = true;
+    if (key == SDLK_F3) toggleProfiler();
+    if (key == SDLK_F4) dumpTrace();
+    if (key == SDLK_F5) toggleCapture();
     switch (gameState) {
         case GameState::TWO_PLAYER_WAITING:
         case GameState::ONE_PLAYER_WAITING:
             if (key == SDLK_SPACE) startGame();
             break;
         case GameState::ONE_PLAYER:
-            if (key == SDLK_SPACE && !birds.empty() && birds[0].alive && !birds[0].collided) {
-                birds[0].velocity = -8.0f;
-                Mix_PlayChannel(-1, sfx_wing, 0);
-            }
+            if (key == SDLK_SPACE) flapBird(0);
             break;
         case GameState::TWO_PLAYER:
-            if (key == SDLK_SPACE && !birds.empty() && birds[0].alive && !birds[0].collided) {
-                birds[0].velocity = -8.0f;
-                Mix_PlayChannel(-1, sfx_wing, 0);
-            }
-            if (birds.size() > 1 && birds[1].alive && !birds[1].collided && key == SDLK_UP) {
-                birds[1].velocity = -8.0f;
-                Mix_PlayChannel(-1, sfx_wing, 0);
+            // Over the network each side flies its own bird with SPACE.
+            if (netGame) {
+                if (key == SDLK_SPACE) flapBird(netConfig.localPlayer);
+                break;
             }
+            if (key == SDLK_SPACE) flapBird(0);
+            if (key == SDLK_UP) flapBird(1);
             break;
         default:
             break;
     }
-    if (showGameOver && key == SDLK_SPACE) reset(gameState == GameState::ONE_PLAYER ? 1 : 2);
+    if (showGameOver && key == SDLK_SPACE) {
+        if (netGame) startNetGame();
+        else reset(gameState == GameState::ONE_PLAYER ? 1 : 2);
+    }
 }
 
 void FlappyBird::handleMouseClick(int x, int y) {
-    switch (gameState) {
-        case GameState::MENU:
-            handleMenuClick(x, y);
+    screenDirty = true;
+    const Button* button = widgets.click(x, y);
+    if (!button) return;
+    playSound(Sound::CLICK);
+    switch (button->action) {
+        case ButtonAction::TOGGLE_SOUND:
+            isMuted = !isMuted;
+            Mix_VolumeMusic(isMuted ? 0 : MIX_MAX_VOLUME);
             break;
-        case GameState::TWO_PLAYER_WAITING:
-        case GameState::ONE_PLAYER_WAITING:
-        case GameState::INFO:
-        case GameState::ONE_PLAYER:
-        case GameState::TWO_PLAYER:
-            if (isPointInRect(x, y, buttons[0].rect)) {
-                Mix_PlayChannel(-1, clickSound, 0);
-                gameState = GameState::MENU;
-                setupMenu();
-                if (lobbyMusic) {
-                    Mix_VolumeMusic(isMuted ? 0 : MIX_MAX_VOLUME);
-                    Mix_PlayMusic(lobbyMusic, -1);
-                }
-            }
+        case ButtonAction::ONE_PLAYER:
+            Mix_HaltMusic();
+            reset(1);
+            break;
+        case ButtonAction::TWO_PLAYERS:
+            Mix_HaltMusic();
+            if (options.hostPort > 0 || options.joinAddress) startNetGame();
+            else reset(2);
+            break;
+        case ButtonAction::INFORMATION:
+            gameState = GameState::INFO;
+            widgets.setScreen(UiScreen::INFO);
+            break;
+        case ButtonAction::RETURN_TO_MENU:
+            returnToMenu();
+            break;
+        case ButtonAction::AI_BIRDS:
+            startAiBirds();
             break;
     }
 }
 
-void FlappyBird::handleMenuClick(int x, int y) {
-    if (soundButton && isPointInRect(x, y, soundButton->rect)) {
-        Mix_PlayChannel(-1, clickSound, 0);
-        isMuted = !isMuted;
+void FlappyBird::returnToMenu() {
+    logPresentLatency();
+    replaying = false;
+    netGame = false;
+    simThread.stop();
+    gameState = GameState::MENU;
+    setupMenu();
+    if (lobbyMusic) {
         Mix_VolumeMusic(isMuted ? 0 : MIX_MAX_VOLUME);
-    } else if (isPointInRect(x, y, buttons[0].rect)) {
-        Mix_PlayChannel(-1, clickSound, 0);
-        Mix_HaltMusic();
-        reset(1);
-    } else if (isPointInRect(x, y, buttons[1].rect)) {
-        Mix_PlayChannel(-1, clickSound, 0);
-        Mix_HaltMusic();
-        reset(2);
-    } else if (isPointInRect(x, y, buttons[2].rect)) {
-        Mix_PlayChannel(-1, clickSound, 0);
-        gameState = GameState::INFO;
-        buttons.clear();
-        SDL_Texture* truongTexture = createTextTexture("-Truong-", infoFont, infoTextCache);
-        int truongW, truongH;
-        SDL_QueryTexture(truongTexture, nullptr, nullptr, &truongW, &truongH);
-        buttons.emplace_back((Constants::WINDOW_WIDTH - truongW) / 2, Constants::WINDOW_HEIGHT - 60, truongW, 30, "Return", true);
+        Mix_PlayMusic(lobbyMusic, -1);
     }
 }
 
 void FlappyBird::handleMouseMotion(int x, int y) {
-    for (auto& button : buttons) handleButtonHover(x, y, button, 5.0f);
-    if (soundButton) handleButtonHover(x, y, *soundButton, 1.2f);
+    if (widgets.hover(x, y)) screenDirty = true;
 }
 
 void FlappyBird::startGame() {
@@ -391,59 +478,182 @@ void FlappyBird::startGame() {
         Mix_VolumeMusic(isMuted ? 0 : 20);
         Mix_PlayMusic(playingMusic, -1);
     }
-    for (auto& bird : birds) {
-        bird.score = 0;
-        bird.alive = true;
-        bird.collided = false;
-        bird.dieSoundPlayed = false;
-    }
+    simThread.start();
     winner = -1;
-    pipes.emplace_back(Constants::WINDOW_WIDTH, rand() % (Constants::WINDOW_HEIGHT - Constants::PIPE_GAP - 100) + 50);
     gameState = (gameState == GameState::TWO_PLAYER_WAITING) ? GameState::TWO_PLAYER : GameState::ONE_PLAYER;
-    buttons.clear();
+    widgets.setScreen(UiScreen::NONE);
 }
 
-void FlappyBird::update() {
-    if (gameState == GameState::MENU || gameState == GameState::INFO ||
-        gameState == GameState::TWO_PLAYER_WAITING || gameState == GameState::ONE_PLAYER_WAITING ||
-        showGameOver) return;
-
-    updateBirdPhysics();
-    updatePipes();
+void FlappyBird::startAiBirds() {
+    if (!loadGameplayAssets(true)) return;
+    if (playingMusic) {
+        Mix_VolumeMusic(isMuted ? 0 : 20);
+        Mix_PlayMusic(playingMusic, -1);
+    }
+    simThread.startAi(options.aiBirds, ++simGeneration, aiGenome.empty() ? nullptr : aiGenome.data(), gameMasks());
+    netGame = false;
+    gameState = GameState::AI_BIRDS;
+    winner = -1;
+    showGameOver = false;
+    widgets.setScreen(UiScreen::RETURN_TO_MENU);
+}
 
-    for (auto& bird : birds) {
-        if (!bird.alive && bird.collided && !bird.dieSoundPlayed) {
-            Mix_PlayChannel(-1, sfx_die, 0);
-            bird.dieSoundPlayed = true;
+void FlappyBird::startNetGame() {
+    if (!loadGameplayAssets(true)) return;
+    netConfig = NetConfig();
+    netConfig.latencyMs = options.netLatencyMs;
+    netConfig.lossPercent = options.netLossPercent;
+    if (options.joinAddress) {
+        netConfig.localPlayer = 1;
+        if (!parseAddress(options.joinAddress, netConfig.peers[0])) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot resolve host %s", options.joinAddress);
+            return;
         }
+    } else {
+        // The host picks the seed; player 2's address is learned from its first packet.
+        netConfig.localPort = static_cast<std::uint16_t>(options.hostPort);
+        netConfig.seed = static_cast<std::uint32_t>(seedSource());
+    }
+    if (playingMusic) {
+        Mix_VolumeMusic(isMuted ? 0 : 20);
+        Mix_PlayMusic(playingMusic, -1);
     }
+    simThread.startNet(&netConfig, ++simGeneration, gameMasks());
+    netGame = true;
+    replaying = false;
+    gameState = GameState::TWO_PLAYER;
+    winner = -1;
+    showGameOver = false;
+    widgets.setScreen(UiScreen::RETURN_TO_MENU);
+}
 
-    spawnPipe();
+const CollisionMasks* FlappyBird::gameMasks() const {
+    // A replay has to be played with the collision it was recorded with.
+    if (replaying && !playback.pixelCollision) return nullptr;
+    if (replaying && !pixelCollision)
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Replay needs pixel collision but the masks are missing");
+    return pixelCollision ? &collisionMasks : nullptr;
+}
 
-    if (birds.empty() || std::all_of(birds.begin(), birds.end(), [](const Bird& b) { return !b.alive; })) {
-        if (!showGameOver) {
-            updateGameOver();
-            showGameOver = true;
-            buttons.clear();
-            buttons.emplace_back(Constants::WINDOW_WIDTH / 2 - 140, Constants::WINDOW_HEIGHT - 60, 280, 30, "Return to Menu", true);
-        }
+void FlappyBird::flapBird(int bird) {
+    // Player 1's bird belongs to the autopilot when one is set.
+    if (replaying || (bird == 0 && options.autopilotUs > 0)) return;
+    simThread.flap(bird, lastInputAt);
+    // The flap lands on the next tick, but its sound is played right away
+    // unless the latest snapshot shows the bird can no longer flap.
+    const SimSnapshot* snapshot = currentSnapshot();
+    if (!snapshot || snapshot->over || bird >= snapshot->birdCount ||
+        !snapshot->alive[bird] || snapshot->collided[bird]) return;
+    mixer.queue(Sound::WING);
+    mixer.markInput(lastInputTicks);
+}
+
+void FlappyBird::startReplay() {
+    if (!readReplay(options.replayFile, playback) || playback.players < 1 || playback.players > 2) {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot play replay %s", options.replayFile);
+        return;
     }
+    replaying = true;
+    reset(playback.players);
+    startGame();
+}
+
+void FlappyBird::finishRecording() {
+    const Replay& recording = simThread.getRecording();
+    if (replaying) {
+        replaying = false;
+        const bool matches = recording.endTick == playback.endTick && recording.scores == playback.scores;
+        SDL_Log("Replay %s %s the recorded result", options.replayFile, matches ? "matches" : "does not match");
+        return;
+    }
+    if (!options.recordDir) return;
+    char path[512];
+    std::snprintf(path, sizeof(path), "%s/replay-%lld-%u.fbr", options.recordDir,
+                  static_cast<long long>(std::time(nullptr)), static_cast<unsigned>(recording.seed));
+    if (!writeReplay(path, recording))
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot write replay %s", path);
 }
 
 void FlappyBird::updateGameOver() {
-    if (gameState == GameState::TWO_PLAYER && birds.size() == 2) {
-        int maxScore = std::max(birds[0].score, birds[1].score);
+    const SimSnapshot* snapshot = currentSnapshot();
+    if (!snapshot) return;
+    const std::int32_t* score = snapshot->score;
+    if (gameState == GameState::TWO_PLAYER && snapshot->birdCount == 2) {
+        int maxScore = std::max(score[0], score[1]);
         highScore = std::max(highScore, maxScore);
-        winner = (birds[0].score > birds[1].score) ? 0 : (birds[1].score > birds[0].score) ? 1 : -1;
-    } else if (birds.size() == 1) {
-        highScore = std::max(highScore, birds[0].score);
+        winner = snapshot->winner;
+    } else if (snapshot->birdCount == 1) {
+        highScore = std::max(highScore, score[0]);
+    }
+    if (replaying || snapshot->birdCount < 1 || snapshot->birdCount > Journal::PLAYERS) return;
+    Journal::Record run = {};
+    run.timestamp = static_cast<std::uint64_t>(std::time(nullptr));
+    run.seed = simThread.getRecording().seed;
+    run.durationMs = static_cast<std::uint32_t>(static_cast<std::uint64_t>(snapshot->tick) * 1000 / Constants::TICK_RATE);
+    run.mode = static_cast<std::uint8_t>(netGame ? Journal::RunMode::NET_VERSUS
+                                         : snapshot->birdCount == 2 ? Journal::RunMode::VERSUS
+                                         : Journal::RunMode::SOLO);
+    run.players = static_cast<std::uint8_t>(snapshot->birdCount);
+    std::copy(score, score + snapshot->birdCount, run.scores);
+    run.winner = snapshot->birdCount == 2 ? snapshot->winner : -1;
+    // Only queued here; the journal thread does the disk work.
+    if (!scoreJournal.record(run))
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "The score journal is behind; this run is not saved");
+}
+
+bool FlappyBird::isIdleScreen() const {
+    if (!options.idleMode || showProfiler) return false;
+    return gameState == GameState::MENU || gameState == GameState::INFO ||
+           gameState == GameState::ONE_PLAYER_WAITING || gameState == GameState::TWO_PLAYER_WAITING ||
+           showGameOver;
+}
+
+void FlappyBird::render(float alpha) {
+    PROFILE_ZONE("render");
+    if (!isIdleScreen()) {
+        composeScene(alpha);
+        // The next static screen has to be composed again.
+        screenDirty = true;
+    } else if (!screenDirty) {
+        // Nothing on a static screen changed, so the last presented frame stays up.
+        return;
+    } else if (screenCache) {
+        SDL_SetRenderTarget(renderer, screenCache);
+        composeScene(1.0f);
+        SDL_SetRenderTarget(renderer, nullptr);
+        SDL_RenderCopy(renderer, screenCache, nullptr, nullptr);
+        screenDirty = false;
+    } else {
+        composeScene(1.0f);
+        screenDirty = false;
     }
+    capture.captureFrame(renderer);
+    PROFILE_ZONE("present");
+    SDL_RenderPresent(renderer);
+    statsPresents++;
+    recordPresentLatency();
+}
+
+void FlappyBird::recordPresentLatency() {
+    const SimSnapshot* snapshot = currentSnapshot();
+    if (!snapshot || snapshot->inputAt <= presentedInputAt) return;
+    presentedInputAt = snapshot->inputAt;
+    presentLatency.record(static_cast<double>(simClockNs() - snapshot->inputAt) / 1e6);
+}
+
+void FlappyBird::logPresentLatency() {
+    if (presentLatency.size() > 0)
+        SDL_Log("Input-to-present latency over %d flaps: avg %.1f ms, p50 %.2f ms, p99 %.2f ms, max %.1f ms",
+                presentLatency.size(), presentLatency.meanMs(), presentLatency.percentileMs(0.5),
+                presentLatency.percentileMs(0.99), presentLatency.maxLatencyMs());
+    presentLatency.clear();
 }
 
-void FlappyBird::render() {
+void FlappyBird::composeScene(float alpha) {
     SDL_RenderClear(renderer);
-    SDL_Rect bgRect = {0, 0, Constants::WINDOW_WIDTH, Constants::WINDOW_HEIGHT};
-    SDL_RenderCopy(renderer, backgroundTexture, nullptr, &bgRect);
+    renderBatch.begin(renderer);
+    drawSprite(Sprite::BACKGROUND,
+                     {0, 0, static_cast<float>(Constants::WINDOW_WIDTH), static_cast<float>(Constants::WINDOW_HEIGHT)});
 
     switch (gameState) {
         case GameState::MENU:
@@ -455,23 +665,31 @@ void FlappyBird::render() {
             break;
         case GameState::ONE_PLAYER:
         case GameState::TWO_PLAYER:
-            renderGameplay();
+            renderGameplay(showGameOver ? 1.0f : alpha);
             break;
         case GameState::INFO:
             renderInfo();
             break;
+        case GameState::AI_BIRDS:
+            renderAiBirds(alpha);
+            break;
     }
-    SDL_RenderPresent(renderer);
+    if (showProfiler) renderProfiler();
+    renderBatch.flush();
 }
 
 void FlappyBird::renderMenu() {
-    SDL_Rect logoRect = {Constants::WINDOW_WIDTH / 2 - 200, 20, 400, 105};
-    SDL_RenderCopy(renderer, logoTexture, nullptr, &logoRect);
+    PROFILE_ZONE("renderMenu");
+    drawSprite(Sprite::LOGO, {Constants::WINDOW_WIDTH / 2 - 200.0f, 20, 400, 105});
     renderButtons();
-    SDL_RenderCopy(renderer, isMuted ? speakerOffTexture : speakerOnTexture, nullptr, &soundButton->rect);
+    const SDL_Rect& speaker = widgets.find(ButtonAction::TOGGLE_SOUND)->rect;
+    drawSprite(isMuted ? Sprite::SPEAKER_OFF : Sprite::SPEAKER_ON,
+                     {static_cast<float>(speaker.x), static_cast<float>(speaker.y),
+                      static_cast<float>(speaker.w), static_cast<float>(speaker.h)});
 }
 
 void FlappyBird::renderWaitingScreen() {
+    PROFILE_ZONE("renderWaitingScreen");
     const bool isTwoPlayer = gameState == GameState::TWO_PLAYER_WAITING;
     renderText(isTwoPlayer ? "2 Player Mode" : "1 Player Mode",
               Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 40, true);
@@ -479,92 +697,313 @@ void FlappyBird::renderWaitingScreen() {
     renderButtons();
 }
 
-void FlappyBird::renderGameplay() {
-    for (size_t i = 0; i < birds.size(); i++) {
-        if (!birds[i].alive) continue;
-        SDL_Rect birdRect = {Constants::WINDOW_WIDTH / 4 + static_cast<int>(i * Constants::BIRD_SPACING),
-                           static_cast<int>(birds[i].y), Constants::BIRD_SIZE, Constants::BIRD_SIZE};
-        SDL_RenderCopy(renderer, i == 0 ? player1Texture : player2Texture, nullptr, &birdRect);
+void FlappyBird::renderGameplay(float alpha) {
+    PROFILE_ZONE("renderGameplay");
+    // The simulation thread has not taken the new game's reset yet.
+    const SimSnapshot* snapshot = currentSnapshot();
+    if (!snapshot) return;
+    const float birdSize = static_cast<float>(Constants::BIRD_SIZE);
+    for (int i = 0; i < snapshot->birdCount; i++) {
+        if (!snapshot->alive[i]) continue;
+        const float y = snapshot->prevY[i] + (snapshot->y[i] - snapshot->prevY[i]) * alpha;
+        const float x = static_cast<float>(snapshot->birdX[i]);
+        const bool secondPlayer = gameState == GameState::TWO_PLAYER && i == 1;
+        drawSprite(secondPlayer ? Sprite::PLAYER2 : Sprite::PLAYER1, {x, y, birdSize, birdSize});
     }
 
-    for (const auto& pipe : pipes) {
-        SDL_Rect topPipe = {pipe.x, 0, Constants::PIPE_WIDTH, pipe.gapY - Constants::PIPE_GAP / 2};
-        SDL_Rect bottomPipe = {pipe.x, pipe.gapY + Constants::PIPE_GAP / 2, Constants::PIPE_WIDTH,
-                             Constants::WINDOW_HEIGHT - (pipe.gapY + Constants::PIPE_GAP / 2)};
-        SDL_RenderCopyEx(renderer, pipeTexture, nullptr, &topPipe, 180, nullptr, SDL_FLIP_NONE);
-        SDL_RenderCopy(renderer, pipeTexture, nullptr, &bottomPipe);
+    for (int i = 0; i < snapshot->pipeCount; i++) {
+        const Pipe& pipe = snapshot->pipes[i];
+        const float x = pipe.prevX + (pipe.x - pipe.prevX) * alpha;
+        const float topH = static_cast<float>(pipe.gapY - Constants::PIPE_GAP / 2);
+        const float bottomY = static_cast<float>(pipe.gapY + Constants::PIPE_GAP / 2);
+        const float pipeW = static_cast<float>(Constants::PIPE_WIDTH);
+        if (topH > 0) drawSprite(Sprite::PIPE_FLIPPED, {x, 0, pipeW, topH});
+        drawSprite(Sprite::PIPE, {x, bottomY, pipeW, Constants::WINDOW_HEIGHT - bottomY});
     }
 
     renderScores();
+    if (netGame && snapshot->net != NetStatus::PLAYING) {
+        renderText(snapshot->net == NetStatus::FAILED ? "Cannot open the network port" : "Waiting for the other player...",
+                   Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 40, true);
+        renderButtons();
+    }
     if (showGameOver) renderGameOver();
 }
 
 void FlappyBird::renderScores() {
-    if (gameState == GameState::ONE_PLAYER && birds.size() == 1) {
-        renderText("Score: " + std::to_string(birds[0].score), 10, 10, false, true);
-    } else if (birds.size() == 2) {
-        renderText("Player 1 Score: " + std::to_string(birds[0].score), 10, 10, false, true);
-        renderText("Player 2 Score: " + std::to_string(birds[1].score), 10, 40, false, true);
+    PROFILE_ZONE("renderScores");
+    const SimSnapshot* snapshot = currentSnapshot();
+    if (!snapshot) return;
+    const std::int32_t* score = snapshot->score;
+    char text[32];
+    if (gameState == GameState::ONE_PLAYER && snapshot->birdCount == 1) {
+        std::snprintf(text, sizeof(text), "Score: %d", score[0]);
+        renderText(text, 10, 10, false, true);
+    } else if (gameState == GameState::TWO_PLAYER && snapshot->birdCount == 2) {
+        std::snprintf(text, sizeof(text), "Player 1 Score: %d", score[0]);
+        renderText(text, 10, 10, false, true);
+        std::snprintf(text, sizeof(text), "Player 2 Score: %d", score[1]);
+        renderText(text, 10, 40, false, true);
     }
 }
 
 void FlappyBird::renderGameOver() {
+    PROFILE_ZONE("renderGameOver");
+    const SimSnapshot* snapshot = currentSnapshot();
+    if (!snapshot) return;
+    const std::int32_t* score = snapshot->score;
+    char text[32];
     renderText("Game Over!", Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 120, true);
-    if (gameState == GameState::ONE_PLAYER && birds.size() == 1) {
-        renderText("Score: " + std::to_string(birds[0].score), Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 70, true);
-        renderText("High Score: " + std::to_string(highScore), Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 20, true);
-        if (birds[0].score == highScore && birds[0].score > 0)
+    if (gameState == GameState::ONE_PLAYER && snapshot->birdCount == 1) {
+        std::snprintf(text, sizeof(text), "Score: %d", score[0]);
+        renderText(text, Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 70, true);
+        std::snprintf(text, sizeof(text), "High Score: %d", highScore);
+        renderText(text, Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 20, true);
+        if (score[0] == highScore && score[0] > 0)
             renderText("New Best High Score!", Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 + 30, true);
         renderText("Press SPACE to Retry", Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 + 80, true);
-    } else if (gameState == GameState::TWO_PLAYER && birds.size() == 2) {
-        renderText("High Score: " + std::to_string(highScore), Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 70, true);
-        renderText(winner == -1 ? "Tie Game!" : "Player " + std::to_string(winner + 1) + " Wins!",
-                  Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 20, true);
-        if ((birds[0].score == highScore || birds[1].score == highScore) && std::max(birds[0].score, birds[1].score) > 0)
+    } else if (gameState == GameState::TWO_PLAYER && snapshot->birdCount == 2) {
+        std::snprintf(text, sizeof(text), "High Score: %d", highScore);
+        renderText(text, Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 70, true);
+        if (winner == -1) std::snprintf(text, sizeof(text), "Tie Game!");
+        else std::snprintf(text, sizeof(text), "Player %d Wins!", winner + 1);
+        renderText(text, Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 - 20, true);
+        if ((score[0] == highScore || score[1] == highScore) && std::max(score[0], score[1]) > 0)
             renderText("New Best High Score!", Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 + 30, true);
         renderText("Press SPACE to Retry", Constants::WINDOW_WIDTH / 2, Constants::WINDOW_HEIGHT / 2 + 80, true);
     }
     renderButtons();
 }
 
+void FlappyBird::renderAiBirds(float alpha) {
+    PROFILE_ZONE("renderAiBirds");
+    renderGameplay(alpha);
+    const SimSnapshot* snapshot = currentSnapshot();
+    if (snapshot) {
+        char text[48];
+        std::snprintf(text, sizeof(text), "Generation: %d", snapshot->aiGeneration + 1);
+        renderText(text, 10, 10, false, true);
+        std::snprintf(text, sizeof(text), "Alive: %d/%d", snapshot->populationAlive, snapshot->population);
+        renderText(text, 10, 40, false, true);
+        std::snprintf(text, sizeof(text), "Score: %d", snapshot->aiScore);
+        renderText(text, 10, 70, false, true);
+    }
+    renderButtons();
+}
+
 void FlappyBird::renderInfo() {
+    PROFILE_ZONE("renderInfo");
     const int startY = 30;
-    const std::vector<std::string> infoLines = {
-        "This game is based on the original",
-        "Flappy Bird by Nguyen Quang Dong.",
-        "Your duty is to make the bird fly",
-        "through pipes as far as possible.",
-        "New mode: 2 players! Player 1 is the",
-        "yellow bird using the SPACE button,",
-        "Player 2 is the green bird using",
-        "UP or DOWN/LEFT/RIGHT buttons.",
-        "Having fun!",
-        "-Truong-"
-    };
-    for (size_t i = 0; i < infoLines.size(); ++i)
-        renderText(infoLines[i], Constants::WINDOW_WIDTH / 2, startY + static_cast<int>(i * 40), true, false, true);
+    for (size_t i = 0; i < SDL_arraysize(INFO_LINES); ++i)
+        renderText(INFO_LINES[i], Constants::WINDOW_WIDTH / 2, startY + static_cast<int>(i * 40), true, false, true);
     renderButtons();
 }
 
 void FlappyBird::renderButtons() {
-    for (const auto& button : buttons) {
-        SDL_Texture* texture = createTextTexture(button.text, button.isRed ? infoFont : font,
-                                               button.isRed ? infoTextCache : textCache, button.isRed);
-        if (!texture) continue;
-        int w, h;
-        SDL_QueryTexture(texture, nullptr, nullptr, &w, &h);
-        SDL_Rect textRect = {button.rect.x + (button.rect.w - w) / 2,
-                           button.rect.y + (button.rect.h - h) / 2, w, h};
-        SDL_RenderCopy(renderer, texture, nullptr, &textRect);
+    PROFILE_ZONE("renderButtons");
+    for (const auto& button : widgets.getButtons()) {
+        const TextStyle style = button.isRed ? TextStyle::INFO_RED : TextStyle::TITLE;
+        textAtlas.drawText(renderBatch, style, button.text,
+                           button.rect.x + (button.rect.w - button.textW) / 2,
+                           button.rect.y + (button.rect.h - button.textH) / 2);
     }
 }
 
 void FlappyBird::run() {
+    Uint64 previous = SDL_GetPerformanceCounter();
     while (running) {
+#ifdef FLAPPY_COUNT_ALLOCS
+        const std::size_t allocationsBefore = AllocCounter::count();
+        const GameState stateBefore = gameState;
+        const bool gameOverBefore = showGameOver;
+#endif
+        // A static screen sleeps until an event arrives. The timeout keeps polling
+        // for gameplay assets that are still loading.
+        const bool idle = isIdleScreen();
+        if (idle && !screenDirty) {
+            const Uint64 waitStart = SDL_GetPerformanceCounter();
+            SDL_WaitEventTimeout(nullptr, IDLE_TIMEOUT_MS);
+            statsWaited += SDL_GetPerformanceCounter() - waitStart;
+        }
+
+        PROFILE_ZONE("frame");
+        profilerToggled = false;
+        const Uint64 frameStart = SDL_GetPerformanceCounter();
+        frameTimes[frameTimeHead] = static_cast<float>(frameStart - previous) * 1000.0f / SDL_GetPerformanceFrequency();
+        frameTimeHead = (frameTimeHead + 1) % FRAME_HISTORY;
+        previous = frameStart;
+        if (options.loopStats) reportLoopStats(frameStart);
+
+        if (!gameplayAssetsLoaded) loadGameplayAssets(false);
         handleInput();
-        update();
-        render();
-        SDL_Delay(16);
+        pollSimulation();
+        if (options.renderStallMs > 0 && !idle && frameStart - lastRenderStall >= SDL_GetPerformanceFrequency()) {
+            // Stands in for a slow present once a second; the simulation thread keeps ticking.
+            SDL_Delay(static_cast<Uint32>(options.renderStallMs));
+            lastRenderStall = frameStart;
+        }
+        const SimSnapshot* snapshot = currentSnapshot();
+        render(snapshot ? snapshotAlpha(*snapshot) : 1.0f);
+        if (telemetry.opened()) publishTelemetry(frameStart, snapshot);
+        if (options.frameMode == FrameMode::TARGET_FPS && !idle) waitForNextFrame(frameStart);
+        statsFrames++;
+#ifdef FLAPPY_COUNT_ALLOCS
+        checkFrameAllocations(AllocCounter::count() - allocationsBefore,
+                              gameState != stateBefore || showGameOver != gameOverBefore || profilerToggled);
+#endif
+    }
+}
+
+void FlappyBird::reportLoopStats(Uint64 now) {
+    constexpr double REPORT_SECONDS = 10.0;
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    if (statsStart == 0) statsStart = now;
+    const double elapsed = static_cast<double>(now - statsStart) / frequency;
+    if (elapsed < REPORT_SECONDS) return;
+    const double waited = static_cast<double>(statsWaited) / frequency;
+    SDL_Log("Loop busy %.1f%% of %.1f s: %d frames, %d presents (%.1f per second)",
+            100.0 * (elapsed - waited) / elapsed, elapsed, statsFrames, statsPresents, statsPresents / elapsed);
+    std::uint64_t ticks = 0;
+    double maxTickGapMs = 0.0;
+    simThread.takeStats(ticks, maxTickGapMs);
+    SDL_Log("Simulation ran %llu ticks (%.1f per second), longest gap between ticks %.2f ms",
+            static_cast<unsigned long long>(ticks), ticks / elapsed, maxTickGapMs);
+    statsStart = now;
+    statsWaited = 0;
+    statsFrames = 0;
+    statsPresents = 0;
+}
+
+void FlappyBird::publishTelemetry(Uint64 frameStart, const SimSnapshot* snapshot) {
+    const Uint64 publishStart = SDL_GetPerformanceCounter();
+    const float frequency = static_cast<float>(SDL_GetPerformanceFrequency());
+    TelemetryFrame& frame = telemetry.begin();
+    frame.frame = telemetryFrames++;
+    frame.gameState = static_cast<std::int32_t>(gameState);
+    frame.frameMs = frameTimes[(frameTimeHead + FRAME_HISTORY - 1) % FRAME_HISTORY];
+    frame.workMs = static_cast<float>(publishStart - frameStart) * 1000.0f / frequency;
+    frame.publishUs = telemetryPublishUs;
+    frame.tick = snapshot ? snapshot->tick : 0;
+    frame.started = snapshot && snapshot->started;
+    frame.over = snapshot && snapshot->over;
+    frame.winner = snapshot ? snapshot->winner : -1;
+    frame.population = snapshot ? snapshot->population : 0;
+    frame.populationAlive = snapshot ? snapshot->populationAlive : 0;
+    frame.birdCount = snapshot ? std::min(snapshot->birdCount, TELEMETRY_BIRDS) : 0;
+    for (int i = 0; i < frame.birdCount; i++) {
+        frame.birds[i].y = snapshot->y[i];
+        frame.birds[i].velocity = snapshot->velocity[i];
+        frame.birds[i].alive = snapshot->alive[i];
+        frame.birds[i].score = snapshot->score[i];
+    }
+    frame.pipeCount = snapshot ? snapshot->pipeCount : 0;
+    for (int i = 0; i < frame.pipeCount; i++) {
+        frame.pipes[i].x = snapshot->pipes[i].x;
+        frame.pipes[i].gapY = snapshot->pipes[i].gapY;
+    }
+    frame.publishedAt = simClockNs();
+    telemetry.publish();
+    telemetryPublishUs = static_cast<float>(SDL_GetPerformanceCounter() - publishStart) * 1000000.0f / frequency;
+}
+
+void FlappyBird::toggleProfiler() {
+    showProfiler = !showProfiler;
+    profilerToggled = true;
+    profilerRefresh = 0;
+    Profiler::setEnabled(showProfiler || options.traceFile);
+}
+
+void FlappyBird::dumpTrace() {
+    if (!options.traceFile) return;
+    profilerToggled = true;
+    if (Profiler::writeChromeTrace(options.traceFile, options.traceSeconds))
+        SDL_Log("Wrote the last %.1f s of profiler zones to %s", options.traceSeconds, options.traceFile);
+    else
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot write trace %s", options.traceFile);
+}
+
+void FlappyBird::toggleCapture() {
+    if (!options.captureDir) return;
+    profilerToggled = true;
+    if (capture.isActive())
+        capture.stop();
+    else if (!capture.start(renderer, options))
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Cannot capture to %s", options.captureDir);
+}
+
+void FlappyBird::renderProfiler() {
+    // Percentiles are recomputed twice a second at 60 fps; the graph updates every frame.
+    constexpr int REFRESH_FRAMES = 30;
+    constexpr float GRAPH_SCALE = 2.0f;     // Pixels per millisecond
+    constexpr float BUDGET_MS = 1000.0f / 60.0f;
+    if (profilerRefresh-- <= 0) {
+        zoneStatCount = Profiler::summarize(2.0, zoneStats, MAX_PROFILE_ZONES);
+        profilerRefresh = REFRESH_FRAMES;
+    }
+
+    const int graphBottom = Constants::WINDOW_HEIGHT - 10;
+    SDL_Rect panel = {0, 0, Constants::WINDOW_WIDTH, Constants::WINDOW_HEIGHT};
+    SDL_Rect bars[FRAME_HISTORY];
+    int slowBars = 0;
+    for (int i = 0; i < FRAME_HISTORY; i++) {
+        const float ms = frameTimes[(frameTimeHead + i) % FRAME_HISTORY];
+        const int h = std::min(static_cast<int>(ms * GRAPH_SCALE), 100);
+        // Frames over budget are moved to the front so they can be drawn in another colour.
+        SDL_Rect bar = {10 + i * 3, graphBottom - h, 2, h};
+        if (ms > BUDGET_MS * 1.5f) {
+            bars[i] = bars[slowBars];
+            bars[slowBars++] = bar;
+        } else {
+            bars[i] = bar;
+        }
+    }
+    const SDL_Rect budgetLine = {10, graphBottom - static_cast<int>(BUDGET_MS * GRAPH_SCALE), FRAME_HISTORY * 3, 1};
+
+    renderBatch.flush();
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 170);
+    SDL_RenderFillRect(renderer, &panel);
+    SDL_SetRenderDrawColor(renderer, 255, 64, 64, 255);
+    SDL_RenderFillRects(renderer, bars, slowBars);
+    SDL_SetRenderDrawColor(renderer, 64, 255, 64, 255);
+    SDL_RenderFillRects(renderer, bars + slowBars, FRAME_HISTORY - slowBars);
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderFillRect(renderer, &budgetLine);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+    SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+
+    char line[96];
+    int y = 10;
+    textAtlas.drawText(renderBatch, TextStyle::HUD, "zone                  count   p50 ms   p99 ms   max ms", 10, y);
+    for (int i = 0; i < zoneStatCount; i++) {
+        y += 16;
+        const ZoneStats& zone = zoneStats[i];
+        std::snprintf(line, sizeof(line), "%-20s %6d %8.3f %8.3f %8.3f", zone.name, zone.count,
+                      zone.p50Ms, zone.p99Ms, zone.maxMs);
+        textAtlas.drawText(renderBatch, TextStyle::HUD, line, 10, y);
+    }
+}
+
+#ifdef FLAPPY_COUNT_ALLOCS
+void FlappyBird::checkFrameAllocations(std::size_t allocations, bool stateChanged) {
+    // Screen changes may grow buffers; only frames after a
+    // warm-up period on an unchanged screen must be allocation free.
+    constexpr int WARMUP_FRAMES = 60;
+    steadyFrames = stateChanged ? 0 : steadyFrames + 1;
+    if (steadyFrames <= WARMUP_FRAMES || allocations == 0) return;
+    SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "%zu heap allocation(s) in a steady-state frame (state %d)",
+                 allocations, static_cast<int>(gameState));
+    std::abort();
+}
+#endif
+
+void FlappyBird::waitForNextFrame(Uint64 frameStart) {
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 deadline = frameStart + frequency / options.targetFps;
+    // SDL_Delay only has millisecond precision, so sleep for most of the wait and spin the rest.
+    for (Uint64 now = SDL_GetPerformanceCounter(); now < deadline; now = SDL_GetPerformanceCounter()) {
+        const Uint64 remainingMs = (deadline - now) * 1000 / frequency;
+        if (remainingMs > 1) SDL_Delay(static_cast<Uint32>(remainingMs - 1));
     }
 }
 
@@ -573,23 +1012,13 @@ bool FlappyBird::isRunning() const {
 }
 
 void FlappyBird::reset(int players) {
+    if (!loadGameplayAssets(true)) return;
     Mix_HaltMusic();
-    birds.clear();
-    pipes.clear();
-    birds.emplace_back(Constants::WINDOW_HEIGHT / 2.0f);
-    if (players == 2) {
-        birds.emplace_back(Constants::WINDOW_HEIGHT / 2.0f);
-        gameState = GameState::TWO_PLAYER_WAITING;
-    } else {
-        gameState = GameState::ONE_PLAYER_WAITING;
-        highScore = std::max(highScore, birds[0].score);
-        birds[0].score = 0;
-        birds[0].alive = true;
-        birds[0].collided = false;
-        birds[0].dieSoundPlayed = false;
-        winner = -1;
-    }
-    buttons.clear();
-    buttons.emplace_back(Constants::WINDOW_WIDTH / 2 - 140, Constants::WINDOW_HEIGHT - 60, 280, 30, "Return to Menu", true);
+    netGame = false;
+    const std::uint32_t seed = replaying ? playback.seed : static_cast<std::uint32_t>(seedSource());
+    simThread.reset(players, seed, ++simGeneration, replaying ? &playback : nullptr, gameMasks());
+    gameState = (players == 2) ? GameState::TWO_PLAYER_WAITING : GameState::ONE_PLAYER_WAITING;
+    winner = -1;
+    widgets.setScreen(UiScreen::RETURN_TO_MENU);
     showGameOver = false;
 }
@@ -5,11 +5,29 @@
 #include <SDL_ttf.h>
 #include <SDL_image.h>
 #include <SDL_mixer.h>
+#include <future>
+#include <random>
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include "constants.h"
 #include "structs.h"
+#include "button.h"
+#include "widgettree.h"
+#include "simthread.h"
+#include "options.h"
+#include "textatlas.h"
+#include "spriteatlas.h"
+#include "renderbatch.h"
+#include "assetloader.h"
+#include "replay.h"
+#include "neuroevolution.h"
+#include "profiler.h"
+#include "soundmixer.h"
+#include "latencyhistogram.h"
+#include "telemetry.h"
+#include "capture.h"
+#include "scorejournal.h"
 
 class FlappyBird {
 private:
@@ -18,83 +36,165 @@ private:
     TTF_Font* font = nullptr;
     TTF_Font* scoreFont = nullptr;
     TTF_Font* infoFont = nullptr;
-    int frameCounter = 0;
-
-    SDL_Texture* backgroundTexture = nullptr;
-    SDL_Texture* logoTexture = nullptr;
-    SDL_Texture* pipeTexture = nullptr;
-    SDL_Texture* player1Texture = nullptr;
-    SDL_Texture* player2Texture = nullptr;
-    SDL_Texture* speakerOnTexture = nullptr;
-    SDL_Texture* speakerOffTexture = nullptr;
-
-    std::vector<Bird> birds;
-    std::vector<Pipe> pipes;
-    std::vector<Button> buttons;
-
-    std::unordered_map<std::string, SDL_Texture*> textCache;
-    std::unordered_map<std::string, SDL_Texture*> scoreTextCache;
-    std::unordered_map<std::string, SDL_Texture*> infoTextCache;
-
-    Mix_Chunk* sfx_die = nullptr;
-    Mix_Chunk* sfx_hit = nullptr;
-    Mix_Chunk* sfx_point = nullptr;
-    Mix_Chunk* sfx_wing = nullptr;
-    Mix_Chunk* clickSound = nullptr;
-    Mix_Chunk* sfx_falling = nullptr;
+    TTF_Font* hudFont = nullptr;
+    // Last composed frame of a static screen, redrawn only when screenDirty is set.
+    SDL_Texture* screenCache = nullptr;
+    bool screenDirty = true;
+
+    AssetLoader assetLoader;
+    SpriteAtlas menuAtlas;
+    SpriteAtlas gameplayAtlas;
+    RenderBatch renderBatch;
+
+    GameOptions options;
+    WidgetTree widgets;
+
+    // Every game gets its own seed so it can be recorded and replayed exactly.
+    std::minstd_rand seedSource;
+    Replay playback;
+    bool replaying = false;
+    // Network loaded with --policy that seeds the AI birds, or empty.
+    std::vector<float> aiGenome;
+
+    // Built from the bird and pipe sprites; games use box collision if that failed.
+    CollisionMasks collisionMasks;
+    bool pixelCollision = false;
+
+    // Two players over UDP when started with --host or --join. The simulation
+    // thread reads netConfig when a networked game starts.
+    NetConfig netConfig;
+    bool netGame = false;
+
+    // Every reset starts a new generation; snapshots of older games are ignored.
+    std::uint32_t simGeneration = 0;
+    std::uint32_t seenGeneration = 0;
+    std::uint32_t seenEvents[SIM_EVENT_TYPES] = {};
+    // Declared after playback, collisionMasks and netConfig, which it reads while a game is running.
+    SimThread simThread;
+
+    // Profiler overlay toggled with F3.
+    static constexpr int FRAME_HISTORY = 120;
+    static constexpr int MAX_PROFILE_ZONES = 24;
+    bool showProfiler = false;
+    bool profilerToggled = false;
+    float frameTimes[FRAME_HISTORY] = {};
+    int frameTimeHead = 0;
+    int profilerRefresh = 0;
+    ZoneStats zoneStats[MAX_PROFILE_ZONES] = {};
+    int zoneStatCount = 0;
+
+    // Loop utilisation reported with --loop-stats.
+    Uint64 statsStart = 0;
+    Uint64 statsWaited = 0;
+    int statsFrames = 0;
+    int statsPresents = 0;
+    Uint64 lastRenderStall = 0;  // Last frame slowed down by --render-stall
+
+    // Live state for spectators and overlays, published with --telemetry.
+    TelemetryWriter telemetry;
+    std::uint64_t telemetryFrames = 0;
+    float telemetryPublishUs = 0.0f;  // Cost of the previous publish
+
+    // Every finished run, appended in the background and compacted into a leaderboard.
+    ScoreJournal scoreJournal;
+
+    // Video and audio written with --capture, started and stopped with F5.
+    GameCapture capture;
+
+    GlyphAtlas textAtlas;
+
+    Mix_Chunk* sounds[static_cast<int>(Sound::COUNT)] = {};
+    SoundMixer mixer;
+    Uint32 lastInputTicks = 0;  // Timestamp of the key event being handled
+    std::uint64_t lastInputAt = 0;  // The same timestamp on simClockNs()
+
+    // Key press to the first present showing its flap, logged once per game.
+    LatencyHistogram presentLatency;
+    std::uint64_t presentedInputAt = 0;
 
     Mix_Music* lobbyMusic = nullptr;
     Mix_Music* playingMusic = nullptr;
 
-    Button* soundButton = nullptr;
+    // Assets still being decoded by assetLoader. Gameplay assets are prefetched
+    // while the menu is shown and only waited for when a game is set up.
+    std::future<SDL_Surface*> pendingSprites[static_cast<int>(Sprite::COUNT)];
+    std::future<Mix_Chunk*> pendingSounds[static_cast<int>(Sound::COUNT)];
+    std::future<Mix_Music*> pendingLobbyMusic;
+    std::future<Mix_Music*> pendingPlayingMusic;
+    bool gameplayAssetsLoaded = false;
+
     bool running = false;
     GameState gameState = GameState::MENU;
     int highScore = 0;
     int winner = -1;
     bool showGameOver = false;
     bool isMuted = false;
-    const std::string HIGH_SCORE_FILE = "highscore.txt";
+#ifdef FLAPPY_COUNT_ALLOCS
+    int steadyFrames = 0;
+#endif
 
     void cleanup();
-    SDL_Texture* createTextTexture(const std::string& text, TTF_Font* targetFont,
-                                 std::unordered_map<std::string, SDL_Texture*>& cache,
-                                 bool isRed = false);
-    void renderText(const std::string& text, int x, int y, bool center = false,
+    void renderText(std::string_view text, int x, int y, bool center = false,
                    bool isScore = false, bool isInfo = false, bool isRed = false);
-    bool isPointInRect(int x, int y, const SDL_Rect& rect) const;
-    SDL_Texture* loadTexture(const char* file);
     bool initSDL();
     bool setupWindowAndRenderer();
     bool loadFontResources();
     bool loadTextureResources();
     bool loadAudioResources();
+    void startAssetLoading();
+    bool loadGameplayAssets(bool wait);
+    void discardPendingAssets();
+    void drawSprite(Sprite sprite, const SDL_FRect& dst);
+    void playSound(Sound sound);
+    void flapBird(int bird);
+    void startReplay();
+    const CollisionMasks* gameMasks() const;
+    void finishRecording();
+    void toggleProfiler();
+    void dumpTrace();
+    void toggleCapture();
+    void renderProfiler();
+    bool isIdleScreen() const;
+    void composeScene(float alpha);
+    void reportLoopStats(Uint64 now);
+    void publishTelemetry(Uint64 frameStart, const SimSnapshot* snapshot);
+    void recordPresentLatency();
+    // Logs the latency of the game that just ended and starts over.
+    void logPresentLatency();
     void setupMenu();
-    void handleButtonHover(int x, int y, Button& button, float scaleFactor);
-    void updateBirdPhysics();
-    void updatePipes();
-    void spawnPipe();
-    int loadHighScore();
-    void saveHighScore();
+    void layoutWidgets();
+    void addButton(UiScreen screen, Button button);
+    void returnToMenu();
+    const SimSnapshot* currentSnapshot() const;
+    void pollSimulation();
+    void waitForNextFrame(Uint64 frameStart);
+#ifdef FLAPPY_COUNT_ALLOCS
+    // Aborts when a frame on an unchanged screen allocates after warm-up.
+    void checkFrameAllocations(std::size_t allocations, bool stateChanged);
+#endif
+    void loadScores();
+    void closeScores();
 
 public:
-    FlappyBird();
+    explicit FlappyBird(const GameOptions& gameOptions = GameOptions());
     ~FlappyBird();
 
     void handleInput();
     void handleKeyDown(SDL_Keycode key);
     void handleMouseClick(int x, int y);
-    void handleMenuClick(int x, int y);
     void handleMouseMotion(int x, int y);
     void startGame();
-    void update();
+    void startAiBirds();
+    void startNetGame();
     void updateGameOver();
-    void render();
+    void render(float alpha);
     void renderMenu();
     void renderWaitingScreen();
-    void renderGameplay();
+    void renderGameplay(float alpha);
     void renderScores();
     void renderGameOver();
     void renderInfo();
+    void renderAiBirds(float alpha);
     void renderButtons();
     void run();
     bool isRunning() const;
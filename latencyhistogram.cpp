@@ -0,0 +1,25 @@
+#include "latencyhistogram.h"
+#include <algorithm>
+
+void LatencyHistogram::record(double ms) {
+    const int bucket = std::clamp(static_cast<int>(ms / BUCKET_MS), 0, BUCKETS - 1);
+    buckets[bucket]++;
+    count++;
+    sumMs += ms;
+    maxMs = std::max(maxMs, ms);
+}
+
+double LatencyHistogram::meanMs() const {
+    return count > 0 ? sumMs / count : 0.0;
+}
+
+double LatencyHistogram::percentileMs(double fraction) const {
+    if (count == 0) return 0.0;
+    const int rank = std::max(1, static_cast<int>(fraction * count + 0.5));
+    int seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) return std::min((i + 1) * BUCKET_MS, maxMs);
+    }
+    return maxMs;
+}
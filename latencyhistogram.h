@@ -0,0 +1,27 @@
+#ifndef LATENCYHISTOGRAM_H
+#define LATENCYHISTOGRAM_H
+
+// Fixed-size histogram of latencies with 0.25 ms buckets up to 100 ms;
+// longer samples land in the last bucket but still count towards the max.
+// Recording never allocates.
+class LatencyHistogram {
+private:
+    static constexpr int BUCKETS = 400;
+    static constexpr double BUCKET_MS = 0.25;
+
+    int buckets[BUCKETS] = {};
+    int count = 0;
+    double sumMs = 0.0;
+    double maxMs = 0.0;
+
+public:
+    void record(double ms);
+    void clear() { *this = LatencyHistogram(); }
+    int size() const { return count; }
+    double meanMs() const;
+    double maxLatencyMs() const { return maxMs; }
+    // Upper edge of the bucket holding the given fraction (0-1) of samples.
+    double percentileMs(double fraction) const;
+};
+
+#endif // LATENCYHISTOGRAM_H
@@ -1,17 +1,69 @@
-<<<<<<< Updated upstream
 #include "flappybird.h"
+#include "options.h"
+#include "replay.h"
+#include "assetloader.h"
+#include "assets.h"
+#include <chrono>
+#include <iostream>
+
+namespace {
+
+// Re-simulates each replay without opening a window and checks it reaches the
+// recorded end tick and scores. Also reports throughput for regression runs.
+int verifyReplays(const std::vector<const char*>& files) {
+    using Clock = std::chrono::steady_clock;
+    Simulation simulation;
+    Replay replay;
+    // Only decoded once a replay played with pixel collision turns up.
+    CollisionMasks masks;
+    bool masksTried = false;
+    bool masksLoaded = false;
+    int failures = 0;
+    unsigned long long ticks = 0;
+    const Clock::time_point begin = Clock::now();
+    for (const char* file : files) {
+        if (!readReplay(file, replay)) {
+            std::cerr << file << ": unreadable replay" << std::endl;
+            failures++;
+            continue;
+        }
+        if (replay.pixelCollision && !masksTried) {
+            masksTried = true;
+            AssetLoader loader;
+            loader.openBundle(Assets::BUNDLE);
+            masksLoaded = loader.loadCollisionMasks(masks);
+            if (!masksLoaded) std::cerr << "cannot load the sprites for pixel collision" << std::endl;
+        }
+        const ReplayResult result = simulateReplay(replay, simulation, masksLoaded ? &masks : nullptr);
+        ticks += result.endTick;
+        if (!replayMatches(replay, result)) {
+            std::cerr << file << ": replay diverged (recorded end tick " << replay.endTick
+                      << ", replayed " << result.endTick << (result.over ? ")" : ", not over)") << std::endl;
+            failures++;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    std::cout << files.size() << " replays, " << failures << " failed, " << ticks << " ticks in "
+              << seconds * 1000.0 << " ms (" << (seconds > 0 ? ticks / seconds : 0.0) << " ticks/s)" << std::endl;
+    return failures == 0 ? 0 : 1;
+}
 
-int main(int argc, char* argv[]) {
-    FlappyBird game;
-    if (game.isRunning()) game.run();
-    return 0;
 }
-=======
-#include "flappybird.h"
 
 int main(int argc, char* argv[]) {
-    FlappyBird game;
+    GameOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: " << argv[0] << " [--vsync | --uncapped | --fps N] [--no-idle] [--loop-stats]"
+                  << " [--render-stall MS] [--low-latency | --audio-buffer N] [--record DIR]"
+                  << " [--replay FILE] [--verify FILE...] [--trace FILE [--trace-seconds N]]"
+                  << " [--ai-birds N] [--policy FILE] [--autopilot US]"
+                  << " [--host PORT | --join HOST:PORT] [--net-latency MS] [--net-loss PERCENT]"
+                  << " [--telemetry NAME] [--capture DIR [--capture-format y4m|raw|png] [--capture-fps N]"
+                  << " [--capture-workers N]]" << std::endl;
+        return 1;
+    }
+    if (!options.verifyFiles.empty()) return verifyReplays(options.verifyFiles);
+    FlappyBird game(options);
     if (game.isRunning()) game.run();
     return 0;
 }
->>>>>>> Stashed changes
@@ -0,0 +1,139 @@
+#include "neuralpolicy.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include "profiler.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr std::size_t ALIGNMENT = 32;
+constexpr int HIDDEN_ROW = NeuralPolicy::INPUTS + 1;
+constexpr int OUTPUT_WEIGHTS = NeuralPolicy::HIDDEN * HIDDEN_ROW;
+constexpr int OUTPUT_BIAS = OUTPUT_WEIGHTS + NeuralPolicy::HIDDEN;
+
+// The few lane operations the forward pass needs, on the widest vectors available.
+#if defined(__AVX2__)
+using Lanes = __m256;
+constexpr int WIDTH = 8;
+inline Lanes load(const float* p) { return _mm256_load_ps(p); }
+inline void store(float* p, Lanes v) { _mm256_store_ps(p, v); }
+inline Lanes add(Lanes a, Lanes b) { return _mm256_add_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+inline Lanes relu(Lanes a) { return _mm256_max_ps(a, _mm256_setzero_ps()); }
+#elif defined(__SSE2__) || defined(_M_X64)
+using Lanes = __m128;
+constexpr int WIDTH = 4;
+inline Lanes load(const float* p) { return _mm_load_ps(p); }
+inline void store(float* p, Lanes v) { _mm_store_ps(p, v); }
+inline Lanes add(Lanes a, Lanes b) { return _mm_add_ps(a, b); }
+inline Lanes mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+inline Lanes relu(Lanes a) { return _mm_max_ps(a, _mm_setzero_ps()); }
+#else
+using Lanes = float;
+constexpr int WIDTH = 1;
+inline Lanes load(const float* p) { return *p; }
+inline void store(float* p, Lanes v) { *p = v; }
+inline Lanes add(Lanes a, Lanes b) { return a + b; }
+inline Lanes mul(Lanes a, Lanes b) { return a * b; }
+inline Lanes relu(Lanes a) { return a > 0.0f ? a : 0.0f; }
+#endif
+
+static_assert(BirdPopulation::LANES % WIDTH == 0, "rows must be whole vectors");
+
+float* allocateRows(int rows, int capacity) {
+    return static_cast<float*>(::operator new[](static_cast<std::size_t>(rows) * capacity * sizeof(float),
+                                                std::align_val_t(ALIGNMENT)));
+}
+
+void freeRows(float* p) {
+    ::operator delete[](p, std::align_val_t(ALIGNMENT));
+}
+
+}
+
+NeuralPolicy::~NeuralPolicy() {
+    release();
+}
+
+void NeuralPolicy::release() {
+    freeRows(weights);
+    freeRows(inputs);
+    freeRows(outputs);
+    weights = inputs = outputs = nullptr;
+    capacity = 0;
+}
+
+void NeuralPolicy::resize(int n) {
+    // Same padding as BirdPopulation, so lane i is bird i in both.
+    const int padded = (n + BirdPopulation::LANES - 1) / BirdPopulation::LANES * BirdPopulation::LANES;
+    if (padded > capacity) {
+        release();
+        capacity = padded;
+        weights = allocateRows(PARAMETERS, capacity);
+        inputs = allocateRows(INPUTS, capacity);
+        outputs = allocateRows(1, capacity);
+        std::memset(weights, 0, static_cast<std::size_t>(PARAMETERS) * capacity * sizeof(float));
+        std::memset(inputs, 0, static_cast<std::size_t>(INPUTS) * capacity * sizeof(float));
+    }
+    count = n;
+}
+
+void NeuralPolicy::gatherInputs(const Simulation& simulation) {
+    float* rowY = inputs;
+    float* rowVelocity = inputs + capacity;
+    float* rowPipeX = inputs + 2 * capacity;
+    float* rowGapY = inputs + 3 * capacity;
+
+    // Birds share a handful of columns, so the next pipe is looked up once per column.
+    int columnX = -1;
+    const Pipe* next = nullptr;
+    for (int i = 0; i < count; i++) {
+        const int birdX = simulation.getBirdX(i);
+        if (birdX != columnX) {
+            columnX = birdX;
+            next = simulation.nextPipe(birdX);
+        }
+        const BirdObservation observation = simulation.observe(i, next);
+        rowY[i] = observation.y;
+        rowVelocity[i] = observation.velocity;
+        rowPipeX[i] = observation.pipeDistance;
+        rowGapY[i] = observation.gapOffset;
+    }
+}
+
+void NeuralPolicy::forward() {
+    const std::size_t stride = capacity;
+    for (int i = 0; i < capacity; i += WIDTH) {
+        Lanes x[INPUTS];
+        for (int f = 0; f < INPUTS; f++) x[f] = load(inputs + f * stride + i);
+        Lanes out = load(weights + OUTPUT_BIAS * stride + i);
+        for (int h = 0; h < HIDDEN; h++) {
+            const float* row = weights + h * HIDDEN_ROW * stride + i;
+            Lanes sum = load(row + INPUTS * stride);
+            for (int f = 0; f < INPUTS; f++) sum = add(sum, mul(load(row + f * stride), x[f]));
+            out = add(out, mul(load(weights + (OUTPUT_WEIGHTS + h) * stride + i), relu(sum)));
+        }
+        store(outputs + i, out);
+    }
+}
+
+int NeuralPolicy::act(Simulation& simulation) {
+    PROFILE_ZONE("policyInference");
+    gatherInputs(simulation);
+    forward();
+    const BirdPopulation& birds = simulation.getBirds();
+    int flaps = 0;
+    for (int i = 0; i < count; i++) {
+        if (outputs[i] > 0.0f && birds.isAlive(i) && !birds.isCollided(i)) {
+            simulation.flap(i);
+            flaps++;
+        }
+    }
+    return flaps;
+}
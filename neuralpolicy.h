@@ -0,0 +1,50 @@
+#ifndef NEURALPOLICY_H
+#define NEURALPOLICY_H
+
+#include "simulation.h"
+
+// One small multilayer perceptron per bird, evaluated for a whole population
+// at once. Parameters are stored parameter-major like BirdPopulation: row p
+// holds parameter p of every network, so each SIMD lane is one bird and a
+// tick costs a few dozen multiply-adds per lane with no gathers.
+//
+// Inputs are the bird's y and velocity and the next pipe's x and gap y, all
+// scaled to roughly [-1, 1]. One ReLU hidden layer feeds a single output; the
+// bird flaps when it is positive.
+class NeuralPolicy {
+public:
+    static constexpr int INPUTS = 4;
+    static constexpr int HIDDEN = 8;
+    // Hidden weights and bias per unit, then output weights and bias.
+    static constexpr int PARAMETERS = HIDDEN * (INPUTS + 1) + HIDDEN + 1;
+
+private:
+    int count = 0;
+    int capacity = 0;
+    float* weights = nullptr;   // PARAMETERS rows of capacity floats
+    float* inputs = nullptr;    // INPUTS rows of capacity floats
+    float* outputs = nullptr;
+
+    void release();
+    void gatherInputs(const Simulation& simulation);
+    void forward();
+
+public:
+    NeuralPolicy() = default;
+    ~NeuralPolicy();
+    NeuralPolicy(const NeuralPolicy&) = delete;
+    NeuralPolicy& operator=(const NeuralPolicy&) = delete;
+
+    // Resizes to n networks. Parameters are zero after growing.
+    void resize(int n);
+    int size() const { return count; }
+    float* parameter(int p) { return weights + static_cast<std::size_t>(p) * capacity; }
+    const float* parameter(int p) const { return weights + static_cast<std::size_t>(p) * capacity; }
+
+    // Runs every network on the birds' current state and flaps the birds
+    // whose output is positive. The population must match the simulation's.
+    // Returns the number of birds that flapped.
+    int act(Simulation& simulation);
+};
+
+#endif // NEURALPOLICY_H
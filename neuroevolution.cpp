@@ -0,0 +1,118 @@
+#include "neuroevolution.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <string>
+
+Evolution::Evolution(unsigned seed) : rng(seed) {}
+
+void Evolution::start(int n, const float* seedGenome) {
+    policy.resize(n);
+    fitness.assign(n, 0.0f);
+    order.resize(n);
+    genomes.resize(static_cast<std::size_t>(n) * NeuralPolicy::PARAMETERS);
+    best.assign(NeuralPolicy::PARAMETERS, 0.0f);
+    bestFitness = -1.0f;
+    generation = 0;
+
+    std::normal_distribution<float> initial(0.0f, 1.0f);
+    std::normal_distribution<float> mutation(0.0f, MUTATION_SCALE);
+    for (int p = 0; p < NeuralPolicy::PARAMETERS; p++) {
+        float* row = policy.parameter(p);
+        for (int i = 0; i < n; i++) {
+            // The first bird keeps the seed genome exactly.
+            if (!seedGenome) row[i] = initial(rng);
+            else row[i] = seedGenome[p] + (i == 0 ? 0.0f : mutation(rng));
+        }
+    }
+    if (seedGenome) std::copy(seedGenome, seedGenome + NeuralPolicy::PARAMETERS, best.begin());
+}
+
+void Evolution::beginGeneration(Simulation& simulation) {
+    simulation.seed(static_cast<unsigned>(rng()));
+    simulation.reset(policy.size());
+    simulation.start();
+    std::fill(fitness.begin(), fitness.end(), 0.0f);
+}
+
+void Evolution::observe(const Simulation& simulation) {
+    const BirdPopulation& birds = simulation.getBirds();
+    const float tick = static_cast<float>(simulation.getTick());
+    for (int i = 0; i < policy.size(); i++)
+        if (birds.isAlive(i) && !birds.isCollided(i)) fitness[i] = tick;
+}
+
+bool Evolution::generationOver(const Simulation& simulation) const {
+    return simulation.isOver() || simulation.getTick() >= MAX_GENERATION_TICKS;
+}
+
+int Evolution::tournament() {
+    std::uniform_int_distribution<int> pick(0, policy.size() - 1);
+    int winner = pick(rng);
+    for (int round = 1; round < TOURNAMENT_SIZE; round++) {
+        const int challenger = pick(rng);
+        if (fitness[challenger] > fitness[winner]) winner = challenger;
+    }
+    return winner;
+}
+
+void Evolution::evolve(const Simulation& simulation) {
+    const int n = policy.size();
+    if (n == 0) return;
+    // Ties keep index order so a run only depends on the seed.
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return fitness[a] > fitness[b] || (fitness[a] == fitness[b] && a < b);
+    });
+    const std::int32_t* score = simulation.getBirds().getScore();
+    lastBestScore = *std::max_element(score, score + n);
+    lastBestFitness = fitness[order[0]];
+    lastMeanFitness = std::accumulate(fitness.begin(), fitness.end(), 0.0f) / n;
+    if (lastBestFitness > bestFitness) {
+        bestFitness = lastBestFitness;
+        for (int p = 0; p < NeuralPolicy::PARAMETERS; p++) best[p] = policy.parameter(p)[order[0]];
+    }
+
+    const int elites = std::max(1, static_cast<int>(n * ELITE_FRACTION));
+    std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+    std::normal_distribution<float> mutation(0.0f, MUTATION_SCALE);
+    for (int k = 0; k < n; k++) {
+        float* child = &genomes[static_cast<std::size_t>(k) * NeuralPolicy::PARAMETERS];
+        if (k < elites) {
+            for (int p = 0; p < NeuralPolicy::PARAMETERS; p++) child[p] = policy.parameter(p)[order[k]];
+            continue;
+        }
+        const int mother = tournament();
+        const int father = tournament();
+        for (int p = 0; p < NeuralPolicy::PARAMETERS; p++) {
+            child[p] = policy.parameter(p)[(rng() & 1) ? mother : father];
+            if (chance(rng) < MUTATION_RATE) child[p] += mutation(rng);
+        }
+    }
+    for (int p = 0; p < NeuralPolicy::PARAMETERS; p++) {
+        float* row = policy.parameter(p);
+        for (int k = 0; k < n; k++) row[k] = genomes[static_cast<std::size_t>(k) * NeuralPolicy::PARAMETERS + p];
+    }
+    generation++;
+}
+
+bool saveGenome(const char* path, const float* genome) {
+    std::ofstream file(path);
+    if (!file) return false;
+    file << "flappy-mlp " << NeuralPolicy::INPUTS << ' ' << NeuralPolicy::HIDDEN << '\n';
+    file.precision(9);
+    for (int p = 0; p < NeuralPolicy::PARAMETERS; p++) file << genome[p] << '\n';
+    return static_cast<bool>(file);
+}
+
+bool loadGenome(const char* path, float* genome) {
+    std::ifstream file(path);
+    std::string magic;
+    int inputs = 0, hidden = 0;
+    if (!(file >> magic >> inputs >> hidden) || magic != "flappy-mlp" ||
+        inputs != NeuralPolicy::INPUTS || hidden != NeuralPolicy::HIDDEN) return false;
+    for (int p = 0; p < NeuralPolicy::PARAMETERS; p++)
+        if (!(file >> genome[p])) return false;
+    return true;
+}
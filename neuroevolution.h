@@ -0,0 +1,67 @@
+#ifndef NEUROEVOLUTION_H
+#define NEUROEVOLUTION_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "neuralpolicy.h"
+#include "simulation.h"
+
+// Generational genetic algorithm over a NeuralPolicy population. All birds of
+// a generation fly the same seeded game, and a bird's fitness is the number
+// of ticks it flew before hitting anything. The best networks pass on
+// unchanged; the rest are bred from tournament-selected parents with uniform
+// crossover and Gaussian mutation.
+class Evolution {
+public:
+    static constexpr float ELITE_FRACTION = 0.05f;
+    static constexpr int TOURNAMENT_SIZE = 3;
+    static constexpr float MUTATION_RATE = 0.1f;    // Chance that a parameter is perturbed
+    static constexpr float MUTATION_SCALE = 0.3f;   // Standard deviation of a perturbation
+    // Longest a generation runs, so a population that never crashes still evolves.
+    static constexpr std::uint32_t MAX_GENERATION_TICKS = Constants::TICK_RATE * 60 * 5;
+
+private:
+    NeuralPolicy policy;
+    std::mt19937 rng;
+    std::vector<float> fitness;
+    std::vector<int> order;
+    std::vector<float> genomes;     // Next generation, one genome after another
+    std::vector<float> best;        // Best genome seen so far
+    float bestFitness = -1.0f;
+    int generation = 0;
+    int lastBestScore = 0;
+    float lastBestFitness = 0.0f;
+    float lastMeanFitness = 0.0f;
+
+    int tournament();
+
+public:
+    explicit Evolution(unsigned seed = 1);
+
+    // Starts generation 0 with n random networks, or with n mutated copies
+    // of seedGenome (NeuralPolicy::PARAMETERS floats) if one is given.
+    void start(int n, const float* seedGenome = nullptr);
+    // Sets the simulation up for a new game of the current generation.
+    void beginGeneration(Simulation& simulation);
+    void act(Simulation& simulation) { policy.act(simulation); }
+    // Credits every bird still flying; call after each step.
+    void observe(const Simulation& simulation);
+    bool generationOver(const Simulation& simulation) const;
+    // Breeds the next generation from the fitness of this one.
+    void evolve(const Simulation& simulation);
+
+    int getGeneration() const { return generation; }
+    const NeuralPolicy& getPolicy() const { return policy; }
+    const float* getBestGenome() const { return best.data(); }
+    // Results of the generation evolve() last bred from.
+    int getLastBestScore() const { return lastBestScore; }
+    float getLastBestFitness() const { return lastBestFitness; }
+    float getLastMeanFitness() const { return lastMeanFitness; }
+};
+
+// Genome files are text: a "flappy-mlp INPUTS HIDDEN" header, then one parameter per line.
+bool saveGenome(const char* path, const float* genome);
+bool loadGenome(const char* path, float* genome);
+
+#endif // NEUROEVOLUTION_H
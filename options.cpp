@@ -0,0 +1,85 @@
+#include "options.h"
+#include <cstdlib>
+#include <cstring>
+
+bool parseOptions(int argc, char* argv[], GameOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (std::strcmp(arg, "--vsync") == 0) {
+            options.frameMode = FrameMode::VSYNC;
+        } else if (std::strcmp(arg, "--uncapped") == 0) {
+            options.frameMode = FrameMode::UNCAPPED;
+        } else if (std::strcmp(arg, "--fps") == 0 && i + 1 < argc) {
+            options.frameMode = FrameMode::TARGET_FPS;
+            options.targetFps = std::atoi(argv[++i]);
+            if (options.targetFps <= 0) return false;
+        } else if (std::strcmp(arg, "--record") == 0 && i + 1 < argc) {
+            options.recordDir = argv[++i];
+        } else if (std::strcmp(arg, "--replay") == 0 && i + 1 < argc) {
+            options.replayFile = argv[++i];
+        } else if (std::strcmp(arg, "--low-latency") == 0) {
+            options.audioBufferSamples = 512;
+        } else if (std::strcmp(arg, "--audio-buffer") == 0 && i + 1 < argc) {
+            // The mixer needs a power of two.
+            options.audioBufferSamples = std::atoi(argv[++i]);
+            const int samples = options.audioBufferSamples;
+            if (samples < 128 || samples > 8192 || (samples & (samples - 1)) != 0) return false;
+        } else if (std::strcmp(arg, "--no-idle") == 0) {
+            options.idleMode = false;
+        } else if (std::strcmp(arg, "--loop-stats") == 0) {
+            options.loopStats = true;
+        } else if (std::strcmp(arg, "--render-stall") == 0 && i + 1 < argc) {
+            options.renderStallMs = std::atoi(argv[++i]);
+            if (options.renderStallMs <= 0) return false;
+        } else if (std::strcmp(arg, "--ai-birds") == 0 && i + 1 < argc) {
+            options.aiBirds = std::atoi(argv[++i]);
+            if (options.aiBirds < 1 || options.aiBirds > 100000) return false;
+        } else if (std::strcmp(arg, "--policy") == 0 && i + 1 < argc) {
+            options.policyFile = argv[++i];
+        } else if (std::strcmp(arg, "--autopilot") == 0 && i + 1 < argc) {
+            // Has to leave most of a tick for the simulation itself.
+            options.autopilotUs = std::atoi(argv[++i]);
+            if (options.autopilotUs < 1 || options.autopilotUs > 10000) return false;
+        } else if (std::strcmp(arg, "--host") == 0 && i + 1 < argc) {
+            options.hostPort = std::atoi(argv[++i]);
+            if (options.hostPort < 1 || options.hostPort > 65535) return false;
+        } else if (std::strcmp(arg, "--join") == 0 && i + 1 < argc) {
+            options.joinAddress = argv[++i];
+        } else if (std::strcmp(arg, "--net-latency") == 0 && i + 1 < argc) {
+            options.netLatencyMs = std::atoi(argv[++i]);
+            if (options.netLatencyMs < 0 || options.netLatencyMs > 1000) return false;
+        } else if (std::strcmp(arg, "--net-loss") == 0 && i + 1 < argc) {
+            options.netLossPercent = std::atoi(argv[++i]);
+            if (options.netLossPercent < 0 || options.netLossPercent > 99) return false;
+        } else if (std::strcmp(arg, "--telemetry") == 0 && i + 1 < argc) {
+            options.telemetryName = argv[++i];
+        } else if (std::strcmp(arg, "--capture") == 0 && i + 1 < argc) {
+            options.captureDir = argv[++i];
+        } else if (std::strcmp(arg, "--capture-format") == 0 && i + 1 < argc) {
+            const char* format = argv[++i];
+            if (std::strcmp(format, "y4m") == 0) options.captureFormat = CaptureFormat::Y4M;
+            else if (std::strcmp(format, "raw") == 0) options.captureFormat = CaptureFormat::RAW;
+            else if (std::strcmp(format, "png") == 0) options.captureFormat = CaptureFormat::PNG;
+            else return false;
+        } else if (std::strcmp(arg, "--capture-fps") == 0 && i + 1 < argc) {
+            options.captureFps = std::atoi(argv[++i]);
+            if (options.captureFps < 1 || options.captureFps > 240) return false;
+        } else if (std::strcmp(arg, "--capture-workers") == 0 && i + 1 < argc) {
+            options.captureWorkers = std::atoi(argv[++i]);
+            if (options.captureWorkers < 1 || options.captureWorkers > 16) return false;
+        } else if (std::strcmp(arg, "--trace") == 0 && i + 1 < argc) {
+            options.traceFile = argv[++i];
+        } else if (std::strcmp(arg, "--trace-seconds") == 0 && i + 1 < argc) {
+            options.traceSeconds = std::atof(argv[++i]);
+            if (options.traceSeconds <= 0) return false;
+        } else if (std::strcmp(arg, "--verify") == 0 && i + 1 < argc) {
+            // Takes every following argument up to the next option, so a shell glob works.
+            while (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+                options.verifyFiles.push_back(argv[++i]);
+            if (options.verifyFiles.empty()) return false;
+        } else {
+            return false;
+        }
+    }
+    return options.hostPort == 0 || !options.joinAddress;
+}
@@ -0,0 +1,53 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <vector>
+
+enum class FrameMode {
+    VSYNC,      // Present is paced by the display refresh
+    UNCAPPED,   // Render as fast as possible
+    TARGET_FPS  // Sleep until the next frame of a fixed rate
+};
+
+enum class CaptureFormat {
+    Y4M,    // One YUV4MPEG2 stream, 4:2:0
+    RAW,    // Raw BGRA frames back to back in one file
+    PNG     // One PNG file per frame
+};
+
+struct GameOptions {
+    FrameMode frameMode = FrameMode::VSYNC;
+    int targetFps = 60;
+    const char* recordDir = nullptr;        // Thư mục lưu replay của mỗi ván
+    const char* replayFile = nullptr;       // Replay được phát lại trên màn hình
+    std::vector<const char*> verifyFiles;   // Replay được mô phỏng lại không cần cửa sổ
+    const char* traceFile = nullptr;        // File Chrome trace ghi khi thoát hoặc bấm F4
+    double traceSeconds = 10.0;             // Số giây cuối cùng được ghi vào trace
+    bool idleMode = true;                   // Màn hình tĩnh chờ sự kiện thay vì vẽ lại liên tục
+    bool loopStats = false;                 // Ghi log tỉ lệ thời gian vòng lặp bận
+    int audioBufferSamples = 2048;          // Kích thước buffer âm thanh (số mẫu)
+    int renderStallMs = 0;                  // Mỗi giây làm chậm một khung hình (đo tick mô phỏng)
+    int aiBirds = 1000;                     // Số chim trong chế độ chim AI
+    const char* policyFile = nullptr;       // Mạng nơ-ron khởi đầu cho chế độ chim AI
+    int autopilotUs = 0;                    // Ngân sách tìm kiếm (µs/tick) khi máy tự lái người chơi 1, 0 nếu tắt
+    int hostPort = 0;                       // Cổng UDP chờ người chơi 2 ở chế độ 2 người qua mạng, 0 nếu không
+    const char* joinAddress = nullptr;      // Địa chỉ host:port của chủ phòng để vào ván qua mạng
+    int netLatencyMs = 0;                   // Độ trễ giả lập thêm vào mỗi gói tin gửi đi
+    int netLossPercent = 0;                 // Phần trăm gói tin gửi đi bị bỏ (giả lập mất gói)
+    const char* telemetryName = nullptr;    // Tên vùng nhớ chia sẻ nhận trạng thái trận đấu mỗi khung hình
+    const char* captureDir = nullptr;       // Thư mục lưu video và âm thanh ghi từ trò chơi (F5 bắt đầu/dừng)
+    CaptureFormat captureFormat = CaptureFormat::Y4M; // Định dạng video ghi lại
+    int captureFps = 60;                    // Số khung hình mỗi giây của video ghi lại
+    int captureWorkers = 2;                 // Số luồng mã hóa và ghi khung hình
+};
+
+// Parses --vsync, --uncapped, --fps N, --record DIR, --replay FILE,
+// --verify FILE..., --trace FILE, --trace-seconds N, --no-idle,
+// --loop-stats, --render-stall MS, --low-latency, --audio-buffer N,
+// --ai-birds N, --policy FILE, --autopilot US, --host PORT, --join HOST:PORT,
+// --net-latency MS, --net-loss PERCENT, --telemetry NAME, --capture DIR,
+// --capture-format y4m|raw|png, --capture-fps N and --capture-workers N.
+// Returns false on an unknown argument, or if both --host and --join are given.
+bool parseOptions(int argc, char* argv[], GameOptions& options);
+
+#endif // OPTIONS_H
@@ -0,0 +1,78 @@
+#ifndef PIPEQUEUE_H
+#define PIPEQUEUE_H
+
+#include <cassert>
+#include "constants.h"
+#include "structs.h"
+
+// Fixed-capacity circular queue of pipes ordered by x. Pushing at the back,
+// popping at the front and iterating never allocate or move other pipes.
+class PipeQueue {
+private:
+    static constexpr int MASK = Constants::PIPE_CAPACITY - 1;
+    static_assert((Constants::PIPE_CAPACITY & MASK) == 0, "PIPE_CAPACITY must be a power of two");
+
+    Pipe pipes[Constants::PIPE_CAPACITY];
+    int head = 0;
+    int count = 0;
+
+public:
+    class ConstIterator {
+    private:
+        const PipeQueue* queue;
+        int index;
+
+    public:
+        ConstIterator(const PipeQueue* q, int i) : queue(q), index(i) {}
+        const Pipe& operator*() const { return (*queue)[index]; }
+        const Pipe* operator->() const { return &(*queue)[index]; }
+        ConstIterator& operator++() { index++; return *this; }
+        bool operator!=(const ConstIterator& other) const { return index != other.index; }
+        bool operator==(const ConstIterator& other) const { return index == other.index; }
+    };
+
+    class Iterator {
+    private:
+        PipeQueue* queue;
+        int index;
+
+    public:
+        Iterator(PipeQueue* q, int i) : queue(q), index(i) {}
+        Pipe& operator*() const { return (*queue)[index]; }
+        Pipe* operator->() const { return &(*queue)[index]; }
+        Iterator& operator++() { index++; return *this; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+        bool operator==(const Iterator& other) const { return index == other.index; }
+    };
+
+    void push_back(const Pipe& pipe) {
+        assert(count < Constants::PIPE_CAPACITY);
+        pipes[(head + count) & MASK] = pipe;
+        count++;
+    }
+    void pop_front() {
+        assert(count > 0);
+        head = (head + 1) & MASK;
+        count--;
+    }
+    void clear() {
+        head = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    int size() const { return count; }
+    Pipe& operator[](int i) { return pipes[(head + i) & MASK]; }
+    const Pipe& operator[](int i) const { return pipes[(head + i) & MASK]; }
+    Pipe& front() { return (*this)[0]; }
+    Pipe& back() { return (*this)[count - 1]; }
+    const Pipe& front() const { return (*this)[0]; }
+    const Pipe& back() const { return (*this)[count - 1]; }
+
+    Iterator begin() { return Iterator(this, 0); }
+    Iterator end() { return Iterator(this, count); }
+    ConstIterator begin() const { return ConstIterator(this, 0); }
+    ConstIterator end() const { return ConstIterator(this, count); }
+};
+
+#endif // PIPEQUEUE_H
@@ -0,0 +1,138 @@
+#include "planner.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// States closer than this in y and velocity are treated as the same state.
+constexpr float Y_STEPS_PER_PIXEL = 4.0f;
+constexpr float VELOCITY_STEPS_PER_UNIT = 16.0f;
+
+}
+
+Planner::Planner(int budgetUs, int horizon) : budgetUs(budgetUs), horizon(horizon) {
+    beam.reserve(2 * MAX_BEAM);
+    next.reserve(2 * MAX_BEAM);
+    slots.assign(SLOT_COUNT, Slot{0, 0, 0});
+}
+
+bool Planner::advance(const Node& node, bool flap, int depth, Node& child) const {
+    // Same float operations as BirdPopulation::integrate, so a line the search
+    // survives is one the game survives.
+    const float groundY = static_cast<float>(Constants::WINDOW_HEIGHT - Constants::BIRD_SIZE);
+    float velocity = (flap ? Constants::FLAP_VELOCITY : node.velocity) + Constants::GRAVITY;
+    float y = node.y + velocity;
+    if (y >= groundY) return false;
+    if (y < 0.0f) {
+        y = 0.0f;
+        velocity = 0.0f;
+    }
+
+    const int birdRight = birdLeft + Constants::BIRD_SIZE;
+    const int shift = depth * Constants::PIPE_SPEED;
+    float target = (Constants::WINDOW_HEIGHT - Constants::BIRD_SIZE) / 2.0f;
+    bool targetFound = false;
+    for (int i = 0; i < obstacleCount; i++) {
+        const Obstacle& pipe = obstacles[i];
+        const int x = pipe.x - shift;
+        if (x + Constants::PIPE_WIDTH <= birdLeft) continue;
+        if (!targetFound) {
+            target = pipe.gapY - Constants::BIRD_SIZE / 2.0f;
+            targetFound = true;
+        }
+        if (x >= birdRight) break;
+        if (y < pipe.top || y >= pipe.lowest) return false;
+    }
+
+    child.y = y;
+    child.velocity = velocity;
+    child.cost = std::fabs(y - target);
+    child.firstFlap = depth == 1 ? flap : node.firstFlap;
+    return true;
+}
+
+bool Planner::remember(const Node& node) {
+    const std::int32_t y = static_cast<std::int32_t>(node.y * Y_STEPS_PER_PIXEL);
+    const std::int32_t velocity = static_cast<std::int32_t>(std::lround(node.velocity * VELOCITY_STEPS_PER_UNIT));
+    std::uint32_t hash = static_cast<std::uint32_t>(y) * 0x9e3779b1u ^ static_cast<std::uint32_t>(velocity) * 0x85ebca77u;
+    for (int probe = 0; probe < SLOT_COUNT; probe++) {
+        Slot& slot = slots[(hash + probe) & (SLOT_COUNT - 1)];
+        if (slot.stamp != stamp) {
+            slot = {stamp, y, velocity};
+            return true;
+        }
+        if (slot.y == y && slot.velocity == velocity) return false;
+    }
+    return true;
+}
+
+bool Planner::decide(const Simulation& simulation, int bird) {
+    const BirdPopulation& birds = simulation.getBirds();
+    if (bird < 0 || bird >= birds.size() || !birds.isAlive(bird) || birds.isCollided(bird)) return false;
+
+    const Clock::time_point begin = Clock::now();
+    const Clock::time_point deadline = begin + std::chrono::microseconds(budgetUs);
+    birdLeft = simulation.getBirdX(bird);
+    // The game tests collisions on the integer part of y, and y is never
+    // negative, so (int)y + BIRD_SIZE > gapBottom is y >= gapBottom - BIRD_SIZE + 1.
+    obstacleCount = 0;
+    for (const Pipe& pipe : simulation.getPipes())
+        obstacles[obstacleCount++] = {pipe.x, pipe.gapY, pipe.gapY - Constants::PIPE_GAP / 2,
+                                      pipe.gapY + Constants::PIPE_GAP / 2 - Constants::BIRD_SIZE + 1};
+
+    beam.clear();
+    beam.push_back({birds.getY()[bird], birds.getVelocity()[bird], 0.0f, false});
+    int depth = 0;
+    bool outOfTime = false;
+    while (depth < horizon) {
+        if (++stamp == 0) {
+            std::fill(slots.begin(), slots.end(), Slot{0, 0, 0});
+            stamp = 1;
+        }
+        next.clear();
+        for (const Node& node : beam) {
+            for (int flap = 0; flap < 2; flap++) {
+                Node child;
+                stats.nodes++;
+                if (!advance(node, flap != 0, depth + 1, child)) continue;
+                if (!remember(child)) {
+                    stats.merged++;
+                    continue;
+                }
+                next.push_back(child);
+            }
+        }
+        // Every line crashes from here on; act on the last layer that did not.
+        if (next.empty()) break;
+        if (static_cast<int>(next.size()) > beamWidth) {
+            std::nth_element(next.begin(), next.begin() + beamWidth, next.end(),
+                             [](const Node& a, const Node& b) { return a.cost < b.cost; });
+            next.resize(beamWidth);
+        }
+        beam.swap(next);
+        depth++;
+        if (Clock::now() >= deadline) {
+            outOfTime = depth < horizon;
+            break;
+        }
+    }
+
+    const Clock::duration elapsed = Clock::now() - begin;
+    if (outOfTime) {
+        stats.truncated++;
+        beamWidth = std::max(MIN_BEAM, beamWidth / 2);
+    } else if (elapsed * 2 < std::chrono::microseconds(budgetUs)) {
+        beamWidth = std::min(MAX_BEAM, beamWidth * 2);
+    }
+    stats.searches++;
+    stats.depthSum += depth;
+    stats.seconds += std::chrono::duration<double>(elapsed).count();
+
+    if (depth == 0) return false;
+    const Node& best = *std::min_element(beam.begin(), beam.end(),
+                                         [](const Node& a, const Node& b) { return a.cost < b.cost; });
+    return best.firstFlap;
+}
@@ -0,0 +1,94 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+
+#include <cstdint>
+#include <vector>
+#include "constants.h"
+#include "simulation.h"
+
+struct PlannerStats {
+    long long searches = 0;
+    long long nodes = 0;            // States simulated
+    long long merged = 0;           // States dropped as equivalent to one already in their layer
+    long long truncated = 0;        // Searches stopped by the time budget before the horizon
+    long long depthSum = 0;         // Ticks looked ahead, summed over searches
+    double seconds = 0.0;           // Time spent searching
+};
+
+// Autopilot for one bird. Every tick it searches the flap/no-flap tree with a
+// beam search over the pipes currently on screen and flaps if the best line
+// found starts with a flap.
+//
+// Search states are just y and velocity: pipes move by a fixed amount per
+// tick, so every state in one layer shares the same pipe positions. States
+// that round to the same y and velocity within a layer are merged, which
+// keeps flaps (which all reset velocity) from filling the beam with copies.
+//
+// The search stops at the horizon or when the time budget runs out, whichever
+// comes first, and then acts on the deepest layer it finished. The beam is
+// narrowed after a search that ran out of time and widened again after ones
+// that finished early, so a slow machine gets a shallower but still timely
+// answer. Pipes are tested as boxes, which is only ever more careful than
+// pixel collision.
+class Planner {
+public:
+    static constexpr int DEFAULT_HORIZON = Constants::TICK_RATE * 3;
+    static constexpr int MIN_BEAM = 8;
+    static constexpr int MAX_BEAM = 256;
+
+private:
+    struct Node {
+        float y;
+        float velocity;
+        float cost;     // Distance from the middle of the gap ahead; lower is better
+        bool firstFlap; // Decision at the root this line started with
+    };
+
+    // A pipe as it was when the search started.
+    struct Obstacle {
+        int x;
+        int gapY;
+        int top;        // Lowest y the bird may have without hitting the upper pipe
+        int lowest;     // First y at which the bird hits the lower pipe
+    };
+
+    // Open-addressed set of the states in the current layer. A slot belongs
+    // to the layer whose stamp it carries, so it never has to be cleared.
+    struct Slot {
+        std::uint32_t stamp;
+        std::int32_t y;
+        std::int32_t velocity;
+    };
+    static constexpr int SLOT_COUNT = 4 * MAX_BEAM;
+
+    int budgetUs;
+    int horizon;
+    int beamWidth = MAX_BEAM;
+    std::vector<Node> beam;
+    std::vector<Node> next;
+    std::vector<Slot> slots;
+    std::uint32_t stamp = 0;
+    Obstacle obstacles[Constants::PIPE_CAPACITY];
+    int obstacleCount = 0;
+    int birdLeft = 0;
+    PlannerStats stats;
+
+    bool advance(const Node& node, bool flap, int depth, Node& child) const;
+    bool remember(const Node& node);
+
+public:
+    // budgetUs is the most time one decision may take, in microseconds.
+    explicit Planner(int budgetUs = 1000, int horizon = DEFAULT_HORIZON);
+
+    void setBudget(int us) { budgetUs = us; }
+    int getBudget() const { return budgetUs; }
+    int getBeamWidth() const { return beamWidth; }
+
+    // Returns true if the bird should flap before the next step.
+    bool decide(const Simulation& simulation, int bird);
+
+    const PlannerStats& getStats() const { return stats; }
+    void resetStats() { stats = PlannerStats(); }
+};
+
+#endif // PLANNER_H
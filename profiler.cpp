@@ -0,0 +1,141 @@
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+// About ten seconds of zones at several hundred frames per second.
+constexpr std::uint64_t RING_CAPACITY = 1 << 17;
+constexpr std::uint64_t RING_MASK = RING_CAPACITY - 1;
+
+struct ThreadRing {
+    ProfileSample slots[RING_CAPACITY];
+    std::atomic<std::uint64_t> head{0};
+    int threadIndex = 0;
+};
+
+std::atomic<bool> enabledFlag{false};
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadRing>> rings;
+thread_local ThreadRing* localRing = nullptr;
+
+ThreadRing* threadRing() {
+    if (!localRing) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        rings.push_back(std::make_unique<ThreadRing>());
+        localRing = rings.back().get();
+        localRing->threadIndex = static_cast<int>(rings.size());
+    }
+    return localRing;
+}
+
+// Appends the samples of one ring that ended at or after since. Slots that
+// the writer may have reused while they were being copied are discarded.
+void snapshot(const ThreadRing& ring, std::uint64_t since, std::vector<ProfileSample>& out) {
+    const std::uint64_t head = ring.head.load(std::memory_order_acquire);
+    const std::uint64_t first = head > RING_CAPACITY ? head - RING_CAPACITY : 0;
+    const std::size_t base = out.size();
+    for (std::uint64_t i = first; i < head; i++) out.push_back(ring.slots[i & RING_MASK]);
+
+    // The writer fills slot after before publishing after + 1, so that one
+    // may be half written too.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const std::uint64_t after = ring.head.load(std::memory_order_relaxed) + 1;
+    const std::uint64_t overwritten = after > RING_CAPACITY ? after - RING_CAPACITY : 0;
+    const std::size_t valid = static_cast<std::size_t>(overwritten > first ? std::min(overwritten - first, head - first) : 0);
+    out.erase(out.begin() + base, out.begin() + base + valid);
+    out.erase(std::remove_if(out.begin() + base, out.end(),
+                             [since](const ProfileSample& s) { return s.end < since; }), out.end());
+}
+
+std::uint64_t windowStart(double windowSeconds) {
+    const std::uint64_t now = Profiler::now();
+    const std::uint64_t window = static_cast<std::uint64_t>(windowSeconds * 1e9);
+    return now > window ? now - window : 0;
+}
+
+}
+
+namespace Profiler {
+
+void setEnabled(bool enabled) {
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+bool isEnabled() {
+    return enabledFlag.load(std::memory_order_relaxed);
+}
+
+std::uint64_t now() {
+    // Never returns 0, which ProfileZone uses to mean "not recording".
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - epoch).count()) + 1;
+}
+
+void record(const char* name, std::uint64_t start, std::uint64_t end) {
+    ThreadRing* ring = threadRing();
+    const std::uint64_t head = ring->head.load(std::memory_order_relaxed);
+    ring->slots[head & RING_MASK] = {name, start, end};
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+int summarize(double windowSeconds, ZoneStats out[], int maxZones) {
+    // Scratch buffers are kept between calls so a visible HUD does not allocate every refresh.
+    static std::vector<ProfileSample> samples;
+    static std::vector<double> durations;
+    samples.clear();
+    const std::uint64_t since = windowStart(windowSeconds);
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        samples.reserve(RING_CAPACITY * rings.size());
+        for (const auto& ring : rings) snapshot(*ring, since, samples);
+    }
+    durations.reserve(samples.size());
+    std::sort(samples.begin(), samples.end(),
+              [](const ProfileSample& a, const ProfileSample& b) { return a.name < b.name; });
+
+    int zones = 0;
+    for (std::size_t i = 0; i < samples.size() && zones < maxZones;) {
+        durations.clear();
+        const char* name = samples[i].name;
+        for (; i < samples.size() && samples[i].name == name; i++)
+            durations.push_back(static_cast<double>(samples[i].end - samples[i].start) / 1e6);
+        std::sort(durations.begin(), durations.end());
+        const std::size_t n = durations.size();
+        out[zones++] = {name, static_cast<int>(n), durations[n / 2], durations[std::min(n - 1, n * 99 / 100)],
+                        durations.back()};
+    }
+    return zones;
+}
+
+bool writeChromeTrace(const char* path, double windowSeconds) {
+    std::vector<ProfileSample> samples;
+    std::vector<int> threadOf;
+    const std::uint64_t since = windowStart(windowSeconds);
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        for (const auto& ring : rings) {
+            snapshot(*ring, since, samples);
+            threadOf.resize(samples.size(), ring->threadIndex);
+        }
+    }
+
+    std::FILE* file = std::fopen(path, "w");
+    if (!file) return false;
+    std::fputs("{\"traceEvents\":[\n", file);
+    for (std::size_t i = 0; i < samples.size(); i++) {
+        std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                     i ? ",\n" : "", samples[i].name, threadOf[i], samples[i].start / 1e3,
+                     (samples[i].end - samples[i].start) / 1e3);
+    }
+    std::fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+    return std::fclose(file) == 0;
+}
+
+}
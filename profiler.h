@@ -0,0 +1,62 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Scoped timing zones. Each thread writes its samples into its own fixed-size
+// ring buffer with a single atomic store, so recording never locks or
+// allocates after the first sample on a thread. Readers copy a snapshot and
+// drop any slot the writer may have overwritten meanwhile.
+//
+// Zone names must be string literals: samples keep the pointer, and stats
+// group zones by pointer.
+struct ProfileSample {
+    const char* name;
+    std::uint64_t start;    // Nanoseconds since the profiler epoch
+    std::uint64_t end;
+};
+
+struct ZoneStats {
+    const char* name;
+    int count;
+    double p50Ms;
+    double p99Ms;
+    double maxMs;
+};
+
+namespace Profiler {
+    // Zones are recorded only while enabled; a disabled zone costs one relaxed load.
+    void setEnabled(bool enabled);
+    bool isEnabled();
+
+    std::uint64_t now();
+    void record(const char* name, std::uint64_t start, std::uint64_t end);
+
+    // Per-zone percentiles over every thread's samples that ended in the last
+    // windowSeconds. Returns the number of zones written, at most maxZones.
+    int summarize(double windowSeconds, ZoneStats out[], int maxZones);
+    // Writes the last windowSeconds of samples as Chrome trace-event JSON.
+    bool writeChromeTrace(const char* path, double windowSeconds);
+}
+
+class ProfileZone {
+private:
+    const char* name;
+    std::uint64_t start;
+
+public:
+    explicit ProfileZone(const char* zoneName)
+        : name(zoneName), start(Profiler::isEnabled() ? Profiler::now() : 0) {}
+    ~ProfileZone() {
+        if (start) Profiler::record(name, start, Profiler::now());
+    }
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+#endif // PROFILER_H
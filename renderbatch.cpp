@@ -0,0 +1,41 @@
+#include "renderbatch.h"
+
+void RenderBatch::begin(SDL_Renderer* target) {
+    renderer = target;
+    texture = nullptr;
+    vertices.clear();
+    indices.clear();
+    drawCalls = 0;
+}
+
+void RenderBatch::addQuad(SDL_Texture* quadTexture, int textureW, int textureH,
+                          const SDL_Rect& src, const SDL_FRect& dst) {
+    if (quadTexture != texture) {
+        flush();
+        texture = quadTexture;
+    }
+    const int base = static_cast<int>(vertices.size());
+    const float u0 = static_cast<float>(src.x) / textureW, v0 = static_cast<float>(src.y) / textureH;
+    const float u1 = static_cast<float>(src.x + src.w) / textureW, v1 = static_cast<float>(src.y + src.h) / textureH;
+    const SDL_Color white = {255, 255, 255, 255};
+    vertices.push_back({{dst.x, dst.y}, white, {u0, v0}});
+    vertices.push_back({{dst.x + dst.w, dst.y}, white, {u1, v0}});
+    vertices.push_back({{dst.x + dst.w, dst.y + dst.h}, white, {u1, v1}});
+    vertices.push_back({{dst.x, dst.y + dst.h}, white, {u0, v1}});
+    const int quad[6] = {base, base + 1, base + 2, base, base + 2, base + 3};
+    indices.insert(indices.end(), quad, quad + 6);
+}
+
+void RenderBatch::flush() {
+    if (!indices.empty()) {
+        SDL_RenderGeometry(renderer, texture, vertices.data(), static_cast<int>(vertices.size()),
+                           indices.data(), static_cast<int>(indices.size()));
+        drawCalls++;
+    }
+    vertices.clear();
+    indices.clear();
+}
+
+int RenderBatch::getDrawCalls() const {
+    return drawCalls;
+}
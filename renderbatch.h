@@ -0,0 +1,25 @@
+#ifndef RENDERBATCH_H
+#define RENDERBATCH_H
+
+#include <SDL.h>
+#include <vector>
+
+// Collects textured quads into one vertex buffer and submits them with
+// SDL_RenderGeometry. A draw call is only issued when the texture changes or
+// the frame is flushed.
+class RenderBatch {
+private:
+    SDL_Renderer* renderer = nullptr;
+    SDL_Texture* texture = nullptr;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+    int drawCalls = 0;
+
+public:
+    void begin(SDL_Renderer* target);
+    void addQuad(SDL_Texture* quadTexture, int textureW, int textureH, const SDL_Rect& src, const SDL_FRect& dst);
+    void flush();
+    int getDrawCalls() const;
+};
+
+#endif // RENDERBATCH_H
@@ -0,0 +1,137 @@
+#include "replay.h"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+constexpr char MAGIC[4] = {'F', 'B', 'R', 'P'};
+constexpr std::uint8_t VERSION = 3;
+constexpr std::uint8_t VERSION_WITHOUT_FLAGS = 2;
+constexpr std::uint8_t VERSION_WITHOUT_SUB_TICK = 1;
+constexpr std::uint64_t FLAG_PIXEL_COLLISION = 1;
+
+void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+bool getVarint(const std::uint8_t*& data, const std::uint8_t* end, std::uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (data == end) return false;
+        const std::uint8_t byte = *data++;
+        value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+}
+
+std::vector<std::uint8_t> encodeReplay(const Replay& replay) {
+    std::vector<std::uint8_t> out(MAGIC, MAGIC + sizeof(MAGIC));
+    out.push_back(VERSION);
+    putVarint(out, replay.seed);
+    putVarint(out, static_cast<std::uint64_t>(replay.players));
+    putVarint(out, replay.pixelCollision ? FLAG_PIXEL_COLLISION : 0);
+    putVarint(out, replay.inputs.size());
+    std::uint32_t lastTick = 0;
+    for (const ReplayInput& input : replay.inputs) {
+        putVarint(out, static_cast<std::uint64_t>(input.tick - lastTick) * replay.players + input.bird);
+        putVarint(out, input.subTick);
+        lastTick = input.tick;
+    }
+    putVarint(out, replay.endTick - lastTick);
+    for (int i = 0; i < replay.players; i++)
+        putVarint(out, i < static_cast<int>(replay.scores.size()) ? static_cast<std::uint32_t>(replay.scores[i]) : 0);
+    return out;
+}
+
+bool decodeReplay(const std::uint8_t* data, std::size_t size, Replay& replay) {
+    const std::uint8_t* end = data + size;
+    if (size < sizeof(MAGIC) + 1 || std::memcmp(data, MAGIC, sizeof(MAGIC)) != 0) return false;
+    const std::uint8_t version = data[sizeof(MAGIC)];
+    if (version != VERSION && version != VERSION_WITHOUT_FLAGS && version != VERSION_WITHOUT_SUB_TICK) return false;
+    data += sizeof(MAGIC) + 1;
+
+    std::uint64_t seed, players, flags = 0, count;
+    if (!getVarint(data, end, seed) || !getVarint(data, end, players)) return false;
+    if (version == VERSION && (!getVarint(data, end, flags) || (flags & ~FLAG_PIXEL_COLLISION) != 0)) return false;
+    if (!getVarint(data, end, count)) return false;
+    // Every input takes at least one byte, which bounds a corrupt count.
+    if (players == 0 || players > 1u << 20 || count > static_cast<std::uint64_t>(end - data)) return false;
+    replay.seed = static_cast<std::uint32_t>(seed);
+    replay.players = static_cast<int>(players);
+    replay.pixelCollision = (flags & FLAG_PIXEL_COLLISION) != 0;
+    replay.inputs.resize(count);
+
+    std::uint64_t tick = 0;
+    for (ReplayInput& input : replay.inputs) {
+        std::uint64_t packed;
+        if (!getVarint(data, end, packed)) return false;
+        tick += packed / players;
+        input.tick = static_cast<std::uint32_t>(tick);
+        input.bird = static_cast<std::uint32_t>(packed % players);
+        std::uint64_t subTick = 0;
+        if (version != VERSION_WITHOUT_SUB_TICK &&
+            (!getVarint(data, end, subTick) || subTick >= Constants::SUB_TICK_STEPS)) return false;
+        input.subTick = static_cast<std::uint32_t>(subTick);
+    }
+    std::uint64_t endDelta;
+    if (!getVarint(data, end, endDelta)) return false;
+    replay.endTick = static_cast<std::uint32_t>(tick + endDelta);
+    replay.scores.resize(replay.players);
+    for (std::int32_t& score : replay.scores) {
+        std::uint64_t value;
+        if (!getVarint(data, end, value)) return false;
+        score = static_cast<std::int32_t>(value);
+    }
+    return data == end;
+}
+
+bool writeReplay(const char* path, const Replay& replay) {
+    const std::vector<std::uint8_t> bytes = encodeReplay(replay);
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+bool readReplay(const char* path, Replay& replay) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decodeReplay(bytes.data(), bytes.size(), replay);
+}
+
+ReplayResult simulateReplay(const Replay& replay, Simulation& simulation, const CollisionMasks* masks) {
+    simulation.setCollisionMasks(replay.pixelCollision ? masks : nullptr);
+    simulation.seed(replay.seed);
+    simulation.reset(replay.players);
+    simulation.start();
+    std::size_t next = 0;
+    while (!simulation.isOver() && simulation.getTick() <= replay.endTick) {
+        for (; next < replay.inputs.size() && replay.inputs[next].tick == simulation.getTick(); next++)
+            simulation.flap(static_cast<int>(replay.inputs[next].bird), flapPhase(replay.inputs[next]));
+        simulation.step();
+        simulation.clearEvents();
+    }
+
+    ReplayResult result;
+    result.endTick = simulation.getTick();
+    result.over = simulation.isOver();
+    const std::int32_t* score = simulation.getBirds().getScore();
+    result.scores.assign(score, score + simulation.getBirds().size());
+    return result;
+}
+
+float flapPhase(const ReplayInput& input) {
+    return static_cast<float>(input.subTick) / Constants::SUB_TICK_STEPS;
+}
+
+bool replayMatches(const Replay& replay, const ReplayResult& result) {
+    return result.over && result.endTick == replay.endTick && result.scores == replay.scores;
+}
@@ -0,0 +1,51 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "simulation.h"
+
+struct ReplayInput {
+    std::uint32_t tick;     // Tick mà cú vỗ cánh có hiệu lực (Simulation::getTick)
+    std::uint32_t bird;     // Chỉ số con chim
+    std::uint32_t subTick;  // Thời điểm trong tick, đơn vị 1/SUB_TICK_STEPS (0 = đầu tick)
+};
+
+// The flap phase Simulation::flap expects for a recorded input.
+float flapPhase(const ReplayInput& input);
+
+// One recorded game: everything needed to re-simulate it exactly, plus the
+// result the game reported so a re-simulation can be checked against it.
+struct Replay {
+    std::uint32_t seed = 0;             // Seed của Simulation trước start()
+    int players = 1;                    // Số chim
+    bool pixelCollision = false;        // Va chạm theo điểm ảnh (CollisionMasks) thay vì hình hộp
+    std::vector<ReplayInput> inputs;    // Các cú vỗ cánh được chấp nhận, theo thứ tự tick
+    std::uint32_t endTick = 0;          // Tick mà ván kết thúc
+    std::vector<std::int32_t> scores;   // Điểm cuối của từng chim
+};
+
+struct ReplayResult {
+    std::uint32_t endTick = 0;
+    bool over = false;
+    std::vector<std::int32_t> scores;
+};
+
+// Binary format: "FBRP", a version byte, then LEB128 varints. Inputs are
+// stored as (tick delta * players + bird) followed by the sub-tick, so most
+// take two or three bytes. Version 1 files have no sub-tick; versions before
+// 3 have no flags after the player count and always used box collision.
+std::vector<std::uint8_t> encodeReplay(const Replay& replay);
+bool decodeReplay(const std::uint8_t* data, std::size_t size, Replay& replay);
+bool writeReplay(const char* path, const Replay& replay);
+bool readReplay(const char* path, Replay& replay);
+
+// Applies each input before the step it was recorded for. Stops when the
+// game is over or one tick past the recorded end, whichever comes first.
+// masks are used if the replay was played with pixel collision; such a
+// replay cannot match without them.
+ReplayResult simulateReplay(const Replay& replay, Simulation& simulation, const CollisionMasks* masks = nullptr);
+bool replayMatches(const Replay& replay, const ReplayResult& result);
+
+#endif // REPLAY_H
@@ -0,0 +1,302 @@
+#include "rollback.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Packet layout, little-endian:
+//   0 "FBNP", 4 version, 5 type, 6 sender, 7 players, 8 seed,
+//   12 sender's current tick, 16 ticks of the receiver's inputs the sender
+//   has, 20 sender's ticks ahead of the receiver (signed), 21 input count,
+//   22 first input tick, 26 one flap bit per input.
+constexpr std::uint8_t MAGIC[4] = {'F', 'B', 'N', 'P'};
+constexpr std::uint8_t VERSION = 1;
+constexpr int HEADER_SIZE = 26;
+
+enum PacketType : std::uint8_t {
+    HELLO = 0,  // Sent until the game starts, to be heard and to hand out the seed
+    INPUT = 1
+};
+
+// Weight of a new frame advantage sample in its running average.
+constexpr float ADVANTAGE_SMOOTHING = 0.1f;
+// Ticks between two skipped ticks, so the average sees the effect of one.
+constexpr int TICKS_BETWEEN_WAITS = 20;
+
+void putU32(std::uint8_t* out, std::uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = static_cast<std::uint8_t>(value >> (8 * i));
+}
+
+std::uint32_t getU32(const std::uint8_t* in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= static_cast<std::uint32_t>(in[i]) << (8 * i);
+    return value;
+}
+
+}
+
+bool RollbackSession::open(const NetConfig& netConfig) {
+    close();
+    if (netConfig.players < 2 || netConfig.players > NET_MAX_PLAYERS) return false;
+    if (netConfig.localPlayer < 0 || netConfig.localPlayer >= netConfig.players) return false;
+    // Only the host can wait to learn where its peers are.
+    for (int p = 0; p < netConfig.players; p++)
+        if (p != netConfig.localPlayer && netConfig.localPlayer != 0 && netConfig.peers[p].port == 0) return false;
+    if (!socket.open(netConfig.localPort)) return false;
+
+    config = netConfig;
+    std::memset(inputs, 0, sizeof(inputs));
+    std::fill(confirmed, confirmed + NET_MAX_PLAYERS, 0);
+    std::fill(acked, acked + NET_MAX_PLAYERS, 0);
+    std::fill(remoteTick, remoteTick + NET_MAX_PLAYERS, 0);
+    std::fill(advantage, advantage + NET_MAX_PLAYERS, 0.0f);
+    std::fill(heard, heard + NET_MAX_PLAYERS, false);
+    seeded = config.localPlayer == 0;
+    seed = seeded ? config.seed : 0;
+    running = false;
+    currentTick = 0;
+    allConfirmed = 0;
+    rollbackFrom = 0;
+    ticksSinceWait = 0;
+    delayedCount = 0;
+    conditions.seed(config.seed ^ static_cast<std::uint32_t>(config.localPlayer + 1));
+    stats = NetStats();
+    return true;
+}
+
+void RollbackSession::close() {
+    socket.close();
+    running = false;
+}
+
+bool RollbackSession::update(Simulation& simulation, bool localFlap, std::uint64_t nowNs) {
+    receivePackets();
+    bool advanced = false;
+    if (!running && synchronized()) {
+        simulation.seed(seed);
+        simulation.reset(config.players);
+        simulation.start();
+        running = true;
+    }
+    if (running) {
+        if (rollbackFrom < currentTick) rollback(simulation);
+        simulation.clearEvents();
+        // An ended game only waits for the inputs that could still revive it.
+        if (!simulation.isOver()) {
+            if (currentTick - allConfirmed >= MAX_PREDICTION) {
+                stats.stalls++;
+            } else if (mustWait()) {
+                stats.waits++;
+            } else {
+                advance(simulation, localFlap);
+                advanced = true;
+            }
+        }
+        confirmInputs();
+    }
+    sendPackets(nowNs);
+    flushDelayed(nowNs);
+    return advanced;
+}
+
+bool RollbackSession::isConfirmedOver(const Simulation& simulation) const {
+    // The inputs of every tick up to the one that ended the game are final.
+    return running && simulation.isOver() && rollbackFrom >= currentTick && allConfirmed >= simulation.getTick();
+}
+
+void RollbackSession::receivePackets() {
+    std::uint8_t buffer[MAX_PACKET];
+    NetAddress from;
+    for (std::size_t size; (size = socket.receive(buffer, sizeof(buffer), from)) > 0;) {
+        stats.packetsReceived++;
+        readPacket(buffer, size, from);
+    }
+}
+
+void RollbackSession::readPacket(const std::uint8_t* data, std::size_t size, const NetAddress& from) {
+    if (size < static_cast<std::size_t>(HEADER_SIZE) || std::memcmp(data, MAGIC, 4) != 0 || data[4] != VERSION)
+        return;
+    const int type = data[5];
+    const int sender = data[6];
+    if (data[7] != config.players || sender >= config.players || sender == config.localPlayer) return;
+    const int count = data[21];
+    if (count > INPUT_WINDOW || size < static_cast<std::size_t>(HEADER_SIZE + (count + 7) / 8)) return;
+
+    // A player's address is learned from its first greeting and fixed after
+    // that; a stray input packet of an earlier game is not taken for one.
+    if (config.peers[sender].port == 0) {
+        if (running || type != HELLO) return;
+        config.peers[sender] = from;
+    } else if (config.peers[sender] != from) {
+        return;
+    }
+    // Packets of another game, such as one just left, carry another seed.
+    const std::uint32_t packetSeed = getU32(data + 8);
+    if (!seeded) {
+        if (sender != 0 || type != HELLO) return;
+        seed = packetSeed;
+        seeded = true;
+    }
+    if (packetSeed != seed) return;
+    heard[sender] = true;
+
+    const std::uint32_t tick = getU32(data + 12);
+    remoteTick[sender] = std::max(remoteTick[sender], tick);
+    acked[sender] = std::max(acked[sender], std::min(getU32(data + 16), currentTick));
+    if (running) {
+        // Ahead by half the difference between what each side sees: the
+        // latency both samples include cancels out.
+        const float local = static_cast<float>(static_cast<std::int32_t>(currentTick - tick));
+        const float remote = static_cast<float>(static_cast<std::int8_t>(data[20]));
+        advantage[sender] += ADVANTAGE_SMOOTHING * ((local - remote) / 2.0f - advantage[sender]);
+    }
+    if (type != INPUT) return;
+
+    const std::uint32_t start = getU32(data + 22);
+    const std::uint8_t* bits = data + HEADER_SIZE;
+    for (int i = 0; i < count; i++) {
+        const std::uint32_t inputTick = start + static_cast<std::uint32_t>(i);
+        if (inputTick < confirmed[sender]) continue;
+        // Inputs are taken in order only; a gap is filled by a later resend.
+        if (inputTick > confirmed[sender] || inputTick >= allConfirmed + INPUT_WINDOW) break;
+        const std::uint8_t flap = (bits[i / 8] >> (i % 8)) & 1;
+        std::uint8_t& slot = inputs[inputTick & (INPUT_WINDOW - 1)][sender];
+        // Ticks before currentTick were simulated with the prediction.
+        if (inputTick < currentTick && flap != slot) rollbackFrom = std::min(rollbackFrom, inputTick);
+        slot = flap;
+        confirmed[sender]++;
+    }
+}
+
+bool RollbackSession::synchronized() const {
+    if (!seeded) return false;
+    for (int p = 0; p < config.players; p++)
+        if (p != config.localPlayer && !heard[p]) return false;
+    return true;
+}
+
+void RollbackSession::rollback(Simulation& simulation) {
+    const std::uint32_t from = rollbackFrom;
+    simulation.loadState(states[from & (STATE_RING - 1)]);
+    for (std::uint32_t tick = from; tick < currentTick; tick++) {
+        if (tick != from) simulation.saveState(states[tick & (STATE_RING - 1)]);
+        applyInputs(simulation, tick);
+        simulation.step();
+    }
+    const int ticks = static_cast<int>(currentTick - from);
+    stats.rollbacks++;
+    stats.resimulatedTicks += ticks;
+    stats.maxRollback = std::max(stats.maxRollback, ticks);
+    rollbackFrom = currentTick;
+}
+
+void RollbackSession::advance(Simulation& simulation, bool localFlap) {
+    std::uint8_t* slot = inputs[currentTick & (INPUT_WINDOW - 1)];
+    for (int p = 0; p < config.players; p++) {
+        // Flaps are rare, so a player not heard from yet is predicted not to.
+        if (p == config.localPlayer) slot[p] = localFlap ? 1 : 0;
+        else if (confirmed[p] <= currentTick) slot[p] = 0;
+    }
+    simulation.saveState(states[currentTick & (STATE_RING - 1)]);
+    applyInputs(simulation, currentTick);
+    simulation.step();
+    currentTick++;
+    rollbackFrom = currentTick;
+    confirmed[config.localPlayer] = currentTick;
+    ticksSinceWait++;
+    stats.ticks++;
+}
+
+void RollbackSession::applyInputs(Simulation& simulation, std::uint32_t tick) const {
+    const std::uint8_t* slot = inputs[tick & (INPUT_WINDOW - 1)];
+    for (int p = 0; p < config.players; p++)
+        if (slot[p]) simulation.flap(p);
+}
+
+bool RollbackSession::mustWait() {
+    if (ticksSinceWait < TICKS_BETWEEN_WAITS) return false;
+    float ahead = 0.0f;
+    for (int p = 0; p < config.players; p++)
+        if (p != config.localPlayer) ahead = std::max(ahead, advantage[p]);
+    if (ahead < 1.0f) return false;
+    ticksSinceWait = 0;
+    return true;
+}
+
+void RollbackSession::confirmInputs() {
+    std::uint32_t now = currentTick;
+    for (int p = 0; p < config.players; p++) now = std::min(now, confirmed[p]);
+    if (recording) {
+        for (std::uint32_t tick = allConfirmed; tick < now; tick++) {
+            const std::uint8_t* slot = inputs[tick & (INPUT_WINDOW - 1)];
+            for (int p = 0; p < config.players; p++)
+                if (slot[p]) recording->inputs.push_back({tick, static_cast<std::uint32_t>(p), 0});
+        }
+    }
+    allConfirmed = std::max(allConfirmed, now);
+}
+
+void RollbackSession::sendPackets(std::uint64_t nowNs) {
+    std::uint8_t packet[MAX_PACKET];
+    std::memcpy(packet, MAGIC, 4);
+    packet[4] = VERSION;
+    packet[5] = running ? INPUT : HELLO;
+    packet[6] = static_cast<std::uint8_t>(config.localPlayer);
+    packet[7] = static_cast<std::uint8_t>(config.players);
+    // Without the seed yet this greets with 0, so the host learns where to send it.
+    putU32(packet + 8, seed);
+    putU32(packet + 12, currentTick);
+    const int local = config.localPlayer;
+    for (int p = 0; p < config.players; p++) {
+        if (p == local || config.peers[p].port == 0) continue;
+        putU32(packet + 16, confirmed[p]);
+        const std::int32_t ahead = static_cast<std::int32_t>(currentTick - remoteTick[p]);
+        packet[20] = static_cast<std::uint8_t>(static_cast<std::int8_t>(std::clamp(ahead, -128, 127)));
+        // Everything the peer has not acknowledged, as far back as the window keeps.
+        const std::uint32_t oldest = currentTick > INPUT_WINDOW ? currentTick - INPUT_WINDOW : 0;
+        const std::uint32_t start = std::max(acked[p], oldest);
+        const int count = running ? static_cast<int>(currentTick - start) : 0;
+        packet[21] = static_cast<std::uint8_t>(count);
+        putU32(packet + 22, start);
+        std::memset(packet + HEADER_SIZE, 0, (count + 7) / 8);
+        for (int i = 0; i < count; i++)
+            if (inputs[(start + i) & (INPUT_WINDOW - 1)][local]) packet[HEADER_SIZE + i / 8] |= 1 << (i % 8);
+        sendPacket(p, packet, HEADER_SIZE + (count + 7) / 8, nowNs);
+    }
+}
+
+void RollbackSession::sendPacket(int peer, const std::uint8_t* data, int size, std::uint64_t nowNs) {
+    if (config.lossPercent > 0 && static_cast<int>(conditions() % 100) < config.lossPercent) {
+        stats.packetsDropped++;
+        return;
+    }
+    stats.packetsSent++;
+    stats.bytesSent += size;
+    if (config.latencyMs <= 0 && config.jitterMs <= 0) {
+        socket.send(config.peers[peer], data, size);
+        return;
+    }
+    if (delayedCount == DELAY_CAPACITY) {
+        stats.packetsDropped++;
+        return;
+    }
+    long long delayUs = config.latencyMs * 1000LL;
+    if (config.jitterMs > 0)
+        delayUs += static_cast<long long>(conditions() % (2000u * config.jitterMs + 1)) - config.jitterMs * 1000LL;
+    DelayedPacket& packet = delayed[delayedCount++];
+    packet.dueNs = nowNs + static_cast<std::uint64_t>(std::max(delayUs, 0LL)) * 1000;
+    packet.peer = peer;
+    packet.size = size;
+    std::memcpy(packet.data, data, size);
+}
+
+void RollbackSession::flushDelayed(std::uint64_t nowNs) {
+    for (int i = 0; i < delayedCount;) {
+        if (delayed[i].dueNs > nowNs) {
+            i++;
+            continue;
+        }
+        socket.send(config.peers[delayed[i].peer], delayed[i].data, delayed[i].size);
+        delayed[i] = delayed[--delayedCount];
+    }
+}
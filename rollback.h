@@ -0,0 +1,139 @@
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <cstdint>
+#include <random>
+#include "replay.h"
+#include "simulation.h"
+#include "udpsocket.h"
+
+constexpr int NET_MAX_PLAYERS = 4;
+
+struct NetConfig {
+    int players = 2;                    // Số người chơi trong ván
+    int localPlayer = 0;                // Người chơi trên máy này; 0 là chủ phòng
+    std::uint16_t localPort = 0;        // Cổng UDP cục bộ, 0 để hệ thống chọn
+    NetAddress peers[NET_MAX_PLAYERS];  // Địa chỉ từng người chơi, cổng 0 nếu chờ gói đầu tiên của họ
+    std::uint32_t seed = 0;             // Seed của ván; chỉ chủ phòng dùng, người khác nhận từ chủ phòng
+    int latencyMs = 0;                  // Độ trễ giả lập thêm vào mỗi gói gửi đi
+    int jitterMs = 0;                   // Độ dao động ngẫu nhiên quanh độ trễ giả lập
+    int lossPercent = 0;                // Phần trăm gói gửi đi bị bỏ (giả lập mất gói)
+};
+
+struct NetStats {
+    long long ticks = 0;                // Ticks advanced
+    long long rollbacks = 0;            // Mispredictions that sent the game back
+    long long resimulatedTicks = 0;     // Ticks simulated again by rollbacks
+    int maxRollback = 0;                // Most ticks one rollback simulated again
+    long long stalls = 0;               // Ticks not advanced because a peer's inputs were too far behind
+    long long waits = 0;                // Ticks not advanced to let a slower peer catch up
+    long long packetsSent = 0;
+    long long packetsReceived = 0;
+    long long packetsDropped = 0;       // Outgoing packets thrown away by the simulated loss
+    long long bytesSent = 0;
+};
+
+// Peer-to-peer rollback session in the style of GGPO. Every player sends its
+// own flaps to every other player each tick; a player whose flaps have not
+// arrived yet is predicted not to flap. When a flap arrives for a tick that
+// was already simulated without it, the simulation is loaded from the state
+// saved before that tick and the ticks since are simulated again, all before
+// the tick that is being advanced now.
+//
+// States are saved into a ring of SimState, one per tick that can still be
+// rolled back, so saving and loading is a copy of the bird arrays and the
+// pipe ring. Inputs are resent until acknowledged, so a lost packet only
+// delays them. The game stops advancing rather than predict more than
+// MAX_PREDICTION ticks, and a player running ahead of the others skips a
+// tick now and then so nobody has to roll back further than the latency.
+//
+// Player 0 hosts: it picks the seed, and its peers' addresses may be left
+// unknown to be learned from their first packet. Everything runs on the
+// calling thread and nothing allocates once the state ring is filled.
+class RollbackSession {
+public:
+    static constexpr int MAX_PREDICTION = 10;   // Ticks simulated past the last confirmed one
+    static constexpr int STATE_RING = 16;
+    static constexpr int INPUT_WINDOW = 64;     // Ticks of inputs kept, and most sent in one packet
+    static constexpr int MAX_PACKET = 64;
+
+private:
+    static_assert(STATE_RING > MAX_PREDICTION, "Every tick that can roll back needs its state");
+    static_assert(INPUT_WINDOW > 2 * MAX_PREDICTION, "Peers may be MAX_PREDICTION ticks either side");
+    static_assert((INPUT_WINDOW & (INPUT_WINDOW - 1)) == 0 && (STATE_RING & (STATE_RING - 1)) == 0,
+                  "Rings are indexed by masking");
+    static constexpr int DELAY_CAPACITY = 256;
+
+    struct DelayedPacket {
+        std::uint64_t dueNs;
+        int peer;
+        int size;
+        std::uint8_t data[MAX_PACKET];
+    };
+
+    NetConfig config;
+    UdpSocket socket;
+    SimState states[STATE_RING];
+    std::uint8_t inputs[INPUT_WINDOW][NET_MAX_PLAYERS] = {};  // 1 = flap, by tick modulo INPUT_WINDOW
+    std::uint32_t confirmed[NET_MAX_PLAYERS] = {};  // Ticks of each player's inputs known, from tick 0
+    std::uint32_t acked[NET_MAX_PLAYERS] = {};      // Ticks of our inputs each peer has confirmed
+    std::uint32_t remoteTick[NET_MAX_PLAYERS] = {}; // Latest tick each peer reported
+    float advantage[NET_MAX_PLAYERS] = {};          // Smoothed ticks we are ahead of each peer
+    bool heard[NET_MAX_PLAYERS] = {};
+    std::uint32_t seed = 0;
+    bool seeded = false;
+    bool running = false;
+    std::uint32_t currentTick = 0;      // Next tick to simulate
+    std::uint32_t allConfirmed = 0;     // Ticks every player's inputs are known for
+    std::uint32_t rollbackFrom = 0;     // Earliest mispredicted tick, currentTick if none
+    int ticksSinceWait = 0;
+    DelayedPacket delayed[DELAY_CAPACITY];
+    int delayedCount = 0;
+    std::minstd_rand conditions;
+    Replay* recording = nullptr;
+    NetStats stats;
+
+    void receivePackets();
+    void readPacket(const std::uint8_t* data, std::size_t size, const NetAddress& from);
+    bool synchronized() const;
+    void rollback(Simulation& simulation);
+    void advance(Simulation& simulation, bool localFlap);
+    void applyInputs(Simulation& simulation, std::uint32_t tick) const;
+    bool mustWait();
+    void confirmInputs();
+    void sendPackets(std::uint64_t nowNs);
+    void sendPacket(int peer, const std::uint8_t* data, int size, std::uint64_t nowNs);
+    void flushDelayed(std::uint64_t nowNs);
+
+public:
+    RollbackSession() = default;
+    RollbackSession(const RollbackSession&) = delete;
+    RollbackSession& operator=(const RollbackSession&) = delete;
+
+    // Opens the socket and forgets any earlier game. Returns false if the
+    // configuration is invalid or the port cannot be bound.
+    bool open(const NetConfig& netConfig);
+    void close();
+
+    // Call once per tick with the local player's flap for it and the time on
+    // any steady clock. Until every player is heard from this only exchanges
+    // greetings; then it seeds, resets and starts simulation. Returns true if
+    // the game advanced a tick, which is the only time localFlap is used.
+    // Afterwards the simulation's events are those of that tick alone.
+    bool update(Simulation& simulation, bool localFlap, std::uint64_t nowNs);
+
+    bool isRunning() const { return running; }
+    // The game is over and no input still to arrive can change that.
+    bool isConfirmedOver(const Simulation& simulation) const;
+    std::uint32_t getSeed() const { return seed; }
+    int getLocalPlayer() const { return config.localPlayer; }
+    std::uint16_t getLocalPort() const { return socket.getLocalPort(); }
+    std::uint32_t getTick() const { return currentTick; }
+    std::uint32_t getConfirmedTick() const { return allConfirmed; }
+    // Confirmed flaps are appended to replay's inputs as phase 0 flaps, in
+    // tick order, until the recording is set to null.
+    void setRecording(Replay* replay) { recording = replay; }
+    const NetStats& getStats() const { return stats; }
+};
+
+#endif // ROLLBACK_H
@@ -0,0 +1,329 @@
+#include "scorejournal.h"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <random>
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+struct CrcTable {
+    std::uint32_t values[256];
+
+    constexpr CrcTable() : values() {
+        for (std::uint32_t i = 0; i < 256; i++) {
+            std::uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) value = (value >> 1) ^ (0xedb88320u & (0u - (value & 1)));
+            values[i] = value;
+        }
+    }
+};
+
+constexpr CrcTable CRC_TABLE;
+
+bool isValid(const Journal::Record& record, std::uint32_t sequence) {
+    return record.sequence == sequence && record.players >= 1 && record.players <= Journal::PLAYERS &&
+           record.mode <= static_cast<std::uint8_t>(Journal::RunMode::NET_VERSUS) &&
+           Journal::crc32(&record, offsetof(Journal::Record, checksum)) == record.checksum;
+}
+
+std::uint64_t newJournalId() {
+    std::random_device device;
+    return (static_cast<std::uint64_t>(device()) << 32 | device()) ^ static_cast<std::uint64_t>(std::time(nullptr));
+}
+
+// Pushes buffered writes down to the device.
+bool syncFile(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Replaces to with from in one step: a reader or a crash sees one file or the other.
+bool replaceFile(const char* from, const char* to) {
+#ifdef _WIN32
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (std::rename(from, to) != 0) return false;
+    // The rename itself is only durable once the directory is.
+    const char* slash = std::strrchr(to, '/');
+    const std::string directory = slash ? std::string(to, slash == to ? 1 : slash - to) : std::string(".");
+    const int fd = ::open(directory.c_str(), O_RDONLY);
+    if (fd < 0) return true;
+    fsync(fd);
+    ::close(fd);
+    return true;
+#endif
+}
+
+bool readLeaderboard(const char* path, Leaderboard& board, std::uint64_t& journalId, std::uint32_t& coveredRecords) {
+    std::FILE* file = std::fopen(path, "rb");
+    if (!file) return false;
+    Journal::LeaderboardHeader header;
+    Journal::Record entries[Leaderboard::SIZE];
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1 &&
+                 std::memcmp(header.magic, Journal::LEADERBOARD_MAGIC, sizeof(header.magic)) == 0 &&
+                 header.version == Journal::VERSION && header.entryCount <= Leaderboard::SIZE &&
+                 std::fread(entries, sizeof(Journal::Record), header.entryCount, file) == header.entryCount;
+    std::fclose(file);
+    if (!valid) return false;
+    const std::uint32_t checksum = header.checksum;
+    header.checksum = 0;
+    const std::uint32_t crc = Journal::crc32(&header, sizeof(header));
+    if (Journal::crc32(entries, header.entryCount * sizeof(Journal::Record), crc) != checksum) return false;
+    for (std::uint32_t i = 0; i < header.entryCount; i++) board.insert(entries[i]);
+    journalId = header.journalId;
+    coveredRecords = header.coveredRecords;
+    return true;
+}
+
+// Moves to record index if the file holds at least that many.
+bool seekRecord(std::FILE* file, std::uint32_t index) {
+    const long offset = static_cast<long>(sizeof(Journal::Header) + static_cast<std::uint64_t>(index) * sizeof(Journal::Record));
+    return std::fseek(file, 0, SEEK_END) == 0 && std::ftell(file) >= offset && std::fseek(file, offset, SEEK_SET) == 0;
+}
+
+// Reads records from the file position on, expecting sequence first, until
+// the first one that is torn, stale or missing. Returns how many were valid.
+std::uint32_t replayRecords(std::FILE* file, std::uint32_t first, Leaderboard& board) {
+    constexpr std::size_t CHUNK = 512;
+    Journal::Record chunk[CHUNK];
+    std::uint32_t next = first;
+    for (;;) {
+        const std::size_t count = std::fread(chunk, sizeof(Journal::Record), CHUNK, file);
+        for (std::size_t i = 0; i < count; i++) {
+            if (!isValid(chunk[i], next)) return next - first;
+            board.insert(chunk[i]);
+            next++;
+        }
+        if (count < CHUNK) return next - first;
+    }
+}
+
+int readLegacyHighScore(const char* path) {
+    std::FILE* file = path ? std::fopen(path, "r") : nullptr;
+    if (!file) return 0;
+    int score = 0;
+    if (std::fscanf(file, "%d", &score) != 1) score = 0;
+    std::fclose(file);
+    return score;
+}
+
+}
+
+namespace Journal {
+
+std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc) {
+    const std::uint8_t* bytes = static_cast<const std::uint8_t*>(data);
+    crc = ~crc;
+    for (std::size_t i = 0; i < size; i++) crc = CRC_TABLE.values[(crc ^ bytes[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+void seal(Record& record) {
+    record.checksum = crc32(&record, offsetof(Record, checksum));
+}
+
+std::int32_t bestScore(const Record& record) {
+    std::int32_t best = record.scores[0];
+    for (int i = 1; i < std::min<int>(record.players, PLAYERS); i++) best = std::max(best, record.scores[i]);
+    return best;
+}
+
+}
+
+void Leaderboard::insert(const Journal::Record& run) {
+    const std::int32_t score = Journal::bestScore(run);
+    int position = count;
+    for (int i = 0; i < count; i++) {
+        // The same run can come from both the leaderboard file and the journal.
+        if (std::memcmp(&entries[i], &run, sizeof(run)) == 0) return;
+        if (position == count && score > Journal::bestScore(entries[i])) position = i;
+    }
+    if (position == SIZE) return;
+    for (int i = std::min(count, SIZE - 1); i > position; i--) entries[i] = entries[i - 1];
+    entries[position] = run;
+    count = std::min(count + 1, SIZE);
+}
+
+std::int32_t Leaderboard::bestScore() const {
+    return count > 0 ? Journal::bestScore(entries[0]) : 0;
+}
+
+ScoreJournal::~ScoreJournal() {
+    close();
+}
+
+void ScoreJournal::open(const char* journalFile, const char* leaderboardFile, const char* legacyFile) {
+    close();
+    const auto start = std::chrono::steady_clock::now();
+    journalPath = journalFile;
+    leaderboardPath = leaderboardFile;
+    recovery = Recovery();
+
+    Leaderboard board;
+    std::uint64_t boardJournal = 0;
+    std::uint32_t boardCovered = 0;
+    const bool haveBoard = readLeaderboard(leaderboardFile, board, boardJournal, boardCovered);
+
+    std::uint32_t records = 0;
+    coveredRecords = 0;
+    journalValid = false;
+    std::FILE* file = std::fopen(journalFile, "rb");
+    Journal::Header header;
+    if (file && std::fread(&header, sizeof(header), 1, file) == 1 &&
+        std::memcmp(header.magic, Journal::MAGIC, sizeof(header.magic)) == 0 && header.version == Journal::VERSION) {
+        journalValid = true;
+        journalId = header.journalId;
+        // A leaderboard of another journal, or one the journal has lost
+        // records of, is merged with a full replay; identical runs count once.
+        if (haveBoard && boardJournal == journalId && seekRecord(file, boardCovered)) coveredRecords = boardCovered;
+        else seekRecord(file, 0);
+        recovery.replayed = replayRecords(file, coveredRecords, board);
+        records = coveredRecords + recovery.replayed;
+    } else {
+        journalId = newJournalId();
+    }
+    if (file) std::fclose(file);
+
+    leaderboard = board;
+    compacted = board;
+    nextSequence = records;
+    written = records;
+    droppedRuns = 0;
+    writeFailures = 0;
+    stopping = false;
+    thread = std::thread(&ScoreJournal::ioLoop, this);
+
+    const int legacyScore = haveBoard || records > 0 ? 0 : readLegacyHighScore(legacyFile);
+    if (legacyScore > 0) {
+        Journal::Record run = {};
+        run.mode = static_cast<std::uint8_t>(Journal::RunMode::SOLO);
+        run.players = 1;
+        run.scores[0] = legacyScore;
+        run.winner = -1;
+        recovery.imported = record(run);
+    }
+    recovery.entries = leaderboard.count;
+    recovery.records = records;
+    recovery.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void ScoreJournal::close() {
+    if (!thread.joinable()) return;
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+bool ScoreJournal::record(Journal::Record run) {
+    // Only keeps identical runs apart on the board in memory; the writer
+    // numbers the run again by its place in the file.
+    run.sequence = nextSequence++;
+    run.reserved = 0;
+    Journal::seal(run);
+    leaderboard.insert(run);
+    if (!thread.joinable() || !queue.push(run)) {
+        droppedRuns++;
+        return false;
+    }
+    // Taking the lock orders the push before a wait that is just about to start.
+    { std::lock_guard<std::mutex> lock(wakeMutex); }
+    wake.notify_one();
+    return true;
+}
+
+void ScoreJournal::ioLoop() {
+    if (!openForAppend()) writeFailures++;
+    for (;;) {
+        bool appended = false;
+        Journal::Record run;
+        while (queue.pop(run)) {
+            // A run that failed to write leaves no gap for the next one.
+            run.sequence = written;
+            Journal::seal(run);
+            compacted.insert(run);
+            if (journal && std::fwrite(&run, sizeof(run), 1, journal) == 1) {
+                written++;
+                appended = true;
+            } else {
+                writeFailures++;
+                // A partly written record would shift every later one.
+                if (journal) seekRecord(journal, written);
+            }
+        }
+        // One flush to the device per batch of runs.
+        if (appended && !syncFile(journal)) writeFailures++;
+        if (written - coveredRecords >= COMPACT_EVERY) compact();
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        if (stopping && queue.empty()) break;
+        wake.wait(lock, [this] { return stopping || !queue.empty(); });
+    }
+    if (written != coveredRecords) compact();
+    if (journal) std::fclose(journal);
+    journal = nullptr;
+}
+
+bool ScoreJournal::openForAppend() {
+    if (journalValid) {
+        // Anything after the last valid record is a torn write and is overwritten.
+        journal = std::fopen(journalPath.c_str(), "r+b");
+        if (journal && seekRecord(journal, written)) return true;
+        if (journal) std::fclose(journal);
+        journal = nullptr;
+        return false;
+    }
+    journal = std::fopen(journalPath.c_str(), "wb");
+    if (!journal) return false;
+    Journal::Header header;
+    std::memcpy(header.magic, Journal::MAGIC, sizeof(header.magic));
+    header.version = Journal::VERSION;
+    header.journalId = journalId;
+    if (std::fwrite(&header, sizeof(header), 1, journal) != 1 || !syncFile(journal)) {
+        std::fclose(journal);
+        journal = nullptr;
+        return false;
+    }
+    journalValid = true;
+    return true;
+}
+
+bool ScoreJournal::compact() {
+    const std::string temporary = leaderboardPath + ".tmp";
+    Journal::LeaderboardHeader header = {};
+    std::memcpy(header.magic, Journal::LEADERBOARD_MAGIC, sizeof(header.magic));
+    header.version = Journal::VERSION;
+    header.journalId = journalId;
+    header.coveredRecords = written;
+    header.entryCount = static_cast<std::uint32_t>(compacted.count);
+    const std::size_t entryBytes = compacted.count * sizeof(Journal::Record);
+    header.checksum = Journal::crc32(compacted.entries, entryBytes, Journal::crc32(&header, sizeof(header)));
+
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    bool saved = file && std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 std::fwrite(compacted.entries, 1, entryBytes, file) == entryBytes && syncFile(file);
+    if (file && std::fclose(file) != 0) saved = false;
+    if (!saved || !replaceFile(temporary.c_str(), leaderboardPath.c_str())) {
+        std::remove(temporary.c_str());
+        writeFailures++;
+        return false;
+    }
+    coveredRecords = written;
+    return true;
+}
@@ -0,0 +1,153 @@
+#ifndef SCOREJOURNAL_H
+#define SCOREJOURNAL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "spscqueue.h"
+
+// On-disk layout of the run journal and the leaderboard compacted from it.
+// All fields are little-endian.
+//
+// The journal is a header followed by fixed-size records, only ever
+// appended. Record n carries sequence n and a CRC-32, so the first torn or
+// stale record marks the end of the journal. The leaderboard file names the
+// journal it was compacted from and how many of its records it covers;
+// startup only reads the records after those.
+namespace Journal {
+    constexpr char MAGIC[4] = {'F', 'B', 'J', 'L'};
+    constexpr char LEADERBOARD_MAGIC[4] = {'F', 'B', 'L', 'B'};
+    constexpr std::uint32_t VERSION = 1;
+    constexpr int PLAYERS = 2;
+
+    enum class RunMode : std::uint8_t {
+        SOLO,       // Chế độ 1 người chơi
+        VERSUS,     // Hai người chơi trên cùng máy
+        NET_VERSUS  // Hai người chơi qua mạng
+    };
+
+    struct Header {
+        char magic[4];              // "FBJL"
+        std::uint32_t version;      // VERSION
+        std::uint64_t journalId;    // Số ngẫu nhiên, đổi khi nhật ký được tạo lại
+    };
+
+    struct Record {
+        std::uint32_t sequence;     // Số thứ tự trong nhật ký, từ 0
+        std::uint32_t seed;         // Seed của ván
+        std::uint64_t timestamp;    // Thời điểm kết thúc ván (giây, Unix), 0 nếu không rõ
+        std::uint32_t durationMs;   // Thời gian chơi
+        std::uint8_t mode;          // RunMode
+        std::uint8_t players;       // Số người chơi
+        std::uint16_t reserved;
+        std::int32_t scores[PLAYERS]; // Điểm của từng người chơi
+        std::int32_t winner;        // Người thắng khi có hai người, -1 nếu hòa hoặc chơi một mình
+        std::uint32_t checksum;     // CRC-32 của các trường phía trước
+    };
+
+    struct LeaderboardHeader {
+        char magic[4];              // "FBLB"
+        std::uint32_t version;      // VERSION
+        std::uint64_t journalId;    // Nhật ký mà bảng được nén từ đó
+        std::uint32_t coveredRecords; // Số bản ghi đầu nhật ký đã tính vào bảng
+        std::uint32_t entryCount;   // Số Record ngay sau header
+        std::uint32_t checksum;     // CRC-32 của header (trường này bằng 0) và các Record
+        std::uint32_t reserved;
+    };
+
+    static_assert(sizeof(Header) == 16 && sizeof(Record) == 40 && sizeof(LeaderboardHeader) == 32,
+                  "journal structs must not be padded");
+
+    std::uint32_t crc32(const void* data, std::size_t size, std::uint32_t crc = 0);
+    // Fills in record.checksum.
+    void seal(Record& record);
+    std::int32_t bestScore(const Record& record);
+}
+
+// The best runs, highest score first; ties go to the earlier run.
+struct Leaderboard {
+    static constexpr int SIZE = 10;
+
+    Journal::Record entries[SIZE] = {};
+    int count = 0;
+
+    // Ignores a run that is already on the board or does not make it.
+    void insert(const Journal::Record& run);
+    std::int32_t bestScore() const;
+};
+
+// Records finished runs without ever waiting for the disk. record() hands
+// the run to a background thread through a lock-free queue; that thread
+// appends it to the journal, flushes it to the device, and rewrites the
+// leaderboard file every COMPACT_EVERY runs and on close(). The leaderboard
+// is replaced through a temporary file and an atomic rename, so a crash
+// leaves either the old or the new one.
+class ScoreJournal {
+public:
+    struct Recovery {
+        int entries = 0;                // Runs on the leaderboard after recovery
+        std::uint32_t records = 0;      // Valid records in the journal
+        std::uint32_t replayed = 0;     // Of those, read because the leaderboard did not cover them
+        bool imported = false;          // The legacy high score file was taken over
+        double ms = 0.0;
+    };
+
+private:
+    static constexpr int QUEUE_CAPACITY = 64;
+    static constexpr std::uint32_t COMPACT_EVERY = 256;
+
+    std::string journalPath;
+    std::string leaderboardPath;
+    std::uint64_t journalId = 0;
+    bool journalValid = false;      // The file has our header and records up to appendAt
+
+    // Main thread.
+    Leaderboard leaderboard;
+    std::uint32_t nextSequence = 0;    // Runs recorded, including dropped ones
+    int droppedRuns = 0;
+    Recovery recovery;
+
+    // Background thread, which also owns the files once it runs.
+    SpscQueue<Journal::Record, QUEUE_CAPACITY> queue;
+    std::thread thread;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    Leaderboard compacted;
+    std::FILE* journal = nullptr;
+    std::uint32_t written = 0;          // Records in the journal, durable once synced
+    std::uint32_t coveredRecords = 0;   // Records the leaderboard file covers
+    int writeFailures = 0;
+
+    void ioLoop();
+    bool openForAppend();
+    bool compact();
+
+public:
+    ScoreJournal() = default;
+    ~ScoreJournal();
+    ScoreJournal(const ScoreJournal&) = delete;
+    ScoreJournal& operator=(const ScoreJournal&) = delete;
+
+    // Loads the leaderboard, replays the journal after it and starts the
+    // writer. A high score in legacyFile is taken over if there is no
+    // journal yet. Never fails; unreadable files start a new journal.
+    void open(const char* journalFile, const char* leaderboardFile, const char* legacyFile);
+    // Waits for pending runs to be written and compacts the leaderboard.
+    void close();
+
+    // Main thread. The writer fills in the sequence and checksum. Returns
+    // false if it is too far behind to take the run; the run still counts
+    // for the leaderboard in memory.
+    bool record(Journal::Record run);
+    const Leaderboard& getLeaderboard() const { return leaderboard; }
+    const Recovery& getRecovery() const { return recovery; }
+    int getDroppedRuns() const { return droppedRuns; }
+    // Valid once close() has returned.
+    int getWriteFailures() const { return writeFailures; }
+};
+
+#endif // SCOREJOURNAL_H
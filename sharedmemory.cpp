@@ -0,0 +1,131 @@
+#include "sharedmemory.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SharedMemory::~SharedMemory() {
+    close();
+}
+
+#ifdef _WIN32
+
+namespace {
+
+// Local\ keeps the mapping in this login session and needs no privileges.
+bool mappingName(const char* name, char* out, std::size_t capacity) {
+    const int length = std::snprintf(out, capacity, "Local\\%s", name);
+    return length > 0 && static_cast<std::size_t>(length) < capacity;
+}
+
+}
+
+bool SharedMemory::create(const char* name, std::size_t bytes) {
+    close();
+    char fullName[128];
+    if (!mappingName(name, fullName, sizeof(fullName))) return false;
+    const unsigned long long size64 = bytes;
+    HANDLE handle = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(size64 >> 32),
+                                       static_cast<DWORD>(size64 & 0xffffffffu), fullName);
+    if (!handle) return false;
+    void* view = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, bytes);
+    if (!view) {
+        CloseHandle(handle);
+        return false;
+    }
+    // A mapping still held open by a reader keeps its old contents.
+    std::memset(view, 0, bytes);
+    mapping = handle;
+    address = view;
+    size = bytes;
+    owner = true;
+    return true;
+}
+
+bool SharedMemory::open(const char* name, std::size_t bytes) {
+    close();
+    char fullName[128];
+    if (!mappingName(name, fullName, sizeof(fullName))) return false;
+    HANDLE handle = OpenFileMappingA(FILE_MAP_READ, FALSE, fullName);
+    if (!handle) return false;
+    void* view = MapViewOfFile(handle, FILE_MAP_READ, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (!view || VirtualQuery(view, &info, sizeof(info)) == 0 || info.RegionSize < bytes) {
+        if (view) UnmapViewOfFile(view);
+        CloseHandle(handle);
+        return false;
+    }
+    mapping = handle;
+    address = view;
+    size = bytes;
+    owner = false;
+    return true;
+}
+
+void SharedMemory::close() {
+    if (address) UnmapViewOfFile(address);
+    if (mapping) CloseHandle(static_cast<HANDLE>(mapping));
+    address = nullptr;
+    mapping = nullptr;
+    size = 0;
+    owner = false;
+}
+
+#else
+
+bool SharedMemory::create(const char* name, std::size_t bytes) {
+    close();
+    const int length = std::snprintf(path, sizeof(path), "/%s", name);
+    if (length <= 1 || static_cast<std::size_t>(length) >= sizeof(path)) return false;
+    // Readers still mapping a block of an earlier run keep it; this run gets a new one.
+    shm_unlink(path);
+    const int fd = shm_open(path, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0) return false;
+    void* view = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(bytes)) == 0)
+        view = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        shm_unlink(path);
+        return false;
+    }
+    address = view;
+    size = bytes;
+    owner = true;
+    return true;
+}
+
+bool SharedMemory::open(const char* name, std::size_t bytes) {
+    close();
+    const int length = std::snprintf(path, sizeof(path), "/%s", name);
+    if (length <= 1 || static_cast<std::size_t>(length) >= sizeof(path)) return false;
+    const int fd = shm_open(path, O_RDONLY, 0);
+    if (fd < 0) return false;
+    struct stat info;
+    void* view = MAP_FAILED;
+    if (fstat(fd, &info) == 0 && static_cast<std::size_t>(info.st_size) >= bytes)
+        view = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) return false;
+    address = view;
+    size = bytes;
+    owner = false;
+    return true;
+}
+
+void SharedMemory::close() {
+    if (address) munmap(address, size);
+    if (owner) shm_unlink(path);
+    address = nullptr;
+    size = 0;
+    owner = false;
+}
+
+#endif
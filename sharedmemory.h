@@ -0,0 +1,37 @@
+#ifndef SHAREDMEMORY_H
+#define SHAREDMEMORY_H
+
+#include <cstddef>
+
+// A named block of memory other processes on the machine can map. Uses
+// shm_open and mmap on POSIX systems and a pagefile-backed file mapping on
+// Windows. Names are plain words; the platform prefix is added here.
+class SharedMemory {
+private:
+    void* address = nullptr;
+    std::size_t size = 0;
+    bool owner = false;
+#ifdef _WIN32
+    void* mapping = nullptr;
+#else
+    char path[64] = {};
+#endif
+
+public:
+    SharedMemory() = default;
+    ~SharedMemory();
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Creates the block, or takes over one left behind by an earlier run,
+    // zero-filled and writable. The name is removed again by close().
+    bool create(const char* name, std::size_t bytes);
+    // Maps an existing block read-only. Fails if it is smaller than bytes.
+    bool open(const char* name, std::size_t bytes);
+    void close();
+
+    void* data() const { return address; }
+    bool opened() const { return address != nullptr; }
+};
+
+#endif // SHAREDMEMORY_H
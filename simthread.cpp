@@ -0,0 +1,383 @@
+#include "simthread.h"
+#include <algorithm>
+#include <chrono>
+#include "profiler.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+constexpr std::chrono::nanoseconds TICK_DURATION(1000000000 / Constants::TICK_RATE);
+// Same room for recorded flaps as a game played on the main thread used to reserve.
+constexpr std::size_t RECORDING_RESERVE = 1 << 14;
+
+std::uint64_t toNs(Clock::time_point time) {
+    return static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count());
+}
+
+}
+
+std::uint64_t simClockNs() {
+    return toNs(Clock::now());
+}
+
+SimThread::SimThread() {
+    recording.inputs.reserve(RECORDING_RESERVE);
+    recording.scores.reserve(SNAPSHOT_BIRDS);
+    thread = std::thread(&SimThread::run, this);
+}
+
+SimThread::~SimThread() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    thread.join();
+}
+
+void SimThread::send(const SimCommand& command) {
+    while (!commands.push(command)) std::this_thread::yield();
+    // Taking the lock orders the push before a wait that is just about to start.
+    { std::lock_guard<std::mutex> lock(wakeMutex); }
+    wake.notify_one();
+}
+
+void SimThread::reset(int players, std::uint32_t seed, std::uint32_t gameGeneration, const Replay* replay,
+                      const CollisionMasks* masks) {
+    SimCommand command = {SimCommandType::RESET, players, seed, gameGeneration, replay};
+    command.masks = masks;
+    send(command);
+}
+
+void SimThread::start() {
+    send({SimCommandType::START, 0, 0, 0, nullptr});
+}
+
+void SimThread::flap(int bird, std::uint64_t inputAt) {
+    send({SimCommandType::FLAP, bird, 0, 0, nullptr, inputAt});
+}
+
+void SimThread::stop() {
+    send({SimCommandType::STOP, 0, 0, 0, nullptr});
+}
+
+void SimThread::startAi(int population, std::uint32_t gameGeneration, const float* genome,
+                        const CollisionMasks* masks) {
+    SimCommand command = {SimCommandType::AI_BIRDS, population, 0, gameGeneration, nullptr};
+    command.genome = genome;
+    command.masks = masks;
+    send(command);
+}
+
+void SimThread::setAutopilot(int budgetUs) {
+    send({SimCommandType::AUTOPILOT, budgetUs, 0, 0, nullptr});
+}
+
+void SimThread::startNet(const NetConfig* config, std::uint32_t gameGeneration, const CollisionMasks* masks) {
+    SimCommand command = {SimCommandType::NET_GAME, config->players, 0, gameGeneration, nullptr};
+    command.masks = masks;
+    command.net = config;
+    send(command);
+}
+
+void SimThread::run() {
+    while (!stopping) {
+        if (applyCommands()) publish();
+
+        std::unique_lock<std::mutex> lock(wakeMutex);
+        const auto woken = [this] { return stopping || !commands.empty(); };
+        if (!ticking()) {
+            wake.wait(lock, woken);
+            continue;
+        }
+        const Clock::time_point now = Clock::now();
+        if (now < nextTick) {
+            wake.wait_until(lock, nextTick, woken);
+            continue;
+        }
+        lock.unlock();
+
+        // Catch up on late ticks, but never more than a frame's worth at once.
+        if (now - nextTick > TICK_DURATION * Constants::MAX_TICKS_PER_FRAME) nextTick = now;
+        {
+            PROFILE_ZONE("update");
+            step();
+            publish();
+        }
+        nextTick += TICK_DURATION;
+    }
+}
+
+bool SimThread::applyCommands() {
+    SimCommand command;
+    // Flaps and the autopilot show with the next tick. Republishing for them
+    // would restart the snapshot's tick and make the birds hitch.
+    bool changed = false;
+    while (commands.pop(command)) {
+        switch (command.type) {
+            case SimCommandType::RESET:
+                changed = true;
+                endNetGame();
+                generation = command.generation;
+                aiMode = false;
+                playback = command.playback;
+                playbackNext = 0;
+                started = false;
+                acceptedInputAt = 0;
+                appliedInputAt = 0;
+                std::fill(eventCounts, eventCounts + SIM_EVENT_TYPES, 0);
+                simulation.setCollisionMasks(command.masks);
+                simulation.seed(command.seed);
+                simulation.reset(command.value);
+                recording.seed = command.seed;
+                recording.players = command.value;
+                recording.pixelCollision = command.masks != nullptr;
+                recording.inputs.clear();
+                recording.scores.clear();
+                recording.endTick = 0;
+                break;
+            case SimCommandType::START:
+                changed = true;
+                simulation.start();
+                started = true;
+                // The first step comes one tick after the start, as it did on the main thread.
+                nextTick = Clock::now() + TICK_DURATION;
+                lastTickAt = 0;
+                break;
+            case SimCommandType::FLAP: {
+                if (netStatus != NetStatus::OFF) {
+                    // Taken with the next tick the session advances.
+                    if (command.value != session.getLocalPlayer() || !session.isRunning()) break;
+                    netFlap = true;
+                    acceptedInputAt = std::max(acceptedInputAt, command.inputAt);
+                    break;
+                }
+                if (!started || playback || simulation.isOver() || (autopilot && command.value == 0)) break;
+                const ReplayInput input = {simulation.getTick(), static_cast<std::uint32_t>(command.value),
+                                           subTickAt(command.inputAt)};
+                if (!simulation.flap(command.value, flapPhase(input))) break;
+                recording.inputs.push_back(input);
+                acceptedInputAt = std::max(acceptedInputAt, command.inputAt);
+                break;
+            }
+            case SimCommandType::STOP:
+                changed = true;
+                endNetGame();
+                started = false;
+                break;
+            case SimCommandType::AI_BIRDS:
+                changed = true;
+                endNetGame();
+                generation = command.generation;
+                aiMode = true;
+                playback = nullptr;
+                acceptedInputAt = 0;
+                appliedInputAt = 0;
+                std::fill(eventCounts, eventCounts + SIM_EVENT_TYPES, 0);
+                simulation.setCollisionMasks(command.masks);
+                evolution.start(command.value, command.genome);
+                evolution.beginGeneration(simulation);
+                started = true;
+                nextTick = Clock::now() + TICK_DURATION;
+                lastTickAt = 0;
+                break;
+            case SimCommandType::AUTOPILOT:
+                autopilot = command.value > 0;
+                if (autopilot) planner.setBudget(command.value);
+                break;
+            case SimCommandType::NET_GAME:
+                changed = true;
+                endNetGame();
+                generation = command.generation;
+                aiMode = false;
+                playback = nullptr;
+                acceptedInputAt = 0;
+                appliedInputAt = 0;
+                netFlap = false;
+                std::fill(eventCounts, eventCounts + SIM_EVENT_TYPES, 0);
+                simulation.setCollisionMasks(command.masks);
+                // Shows the birds at their start until the session starts the game.
+                simulation.reset(command.value);
+                recording.players = command.value;
+                recording.pixelCollision = command.masks != nullptr;
+                recording.inputs.clear();
+                recording.scores.clear();
+                recording.endTick = 0;
+                started = session.open(*command.net);
+                netStatus = started ? NetStatus::WAITING : NetStatus::FAILED;
+                session.setRecording(&recording);
+                nextTick = Clock::now() + TICK_DURATION;
+                lastTickAt = 0;
+                break;
+        }
+    }
+    // The main thread voices its own flaps as soon as the key is pressed.
+    simulation.clearEvents();
+    return changed;
+}
+
+void SimThread::step() {
+    if (netStatus != NetStatus::OFF) {
+        stepNet();
+        recordTickGap();
+        return;
+    }
+    if (aiMode) {
+        // Silent and unrecorded: a new generation starts as soon as the last one dies out.
+        evolution.act(simulation);
+        simulation.step();
+        simulation.clearEvents();
+        evolution.observe(simulation);
+        if (evolution.generationOver(simulation)) {
+            evolution.evolve(simulation);
+            evolution.beginGeneration(simulation);
+        }
+        recordTickGap();
+        return;
+    }
+
+    for (; playback && playbackNext < playback->inputs.size() &&
+           playback->inputs[playbackNext].tick == simulation.getTick(); playbackNext++)
+        simulation.flap(static_cast<int>(playback->inputs[playbackNext].bird), flapPhase(playback->inputs[playbackNext]));
+    if (autopilot && !playback && planner.decide(simulation, 0) && simulation.flap(0))
+        recording.inputs.push_back({simulation.getTick(), 0, 0});
+    simulation.step();
+    appliedInputAt = acceptedInputAt;
+    for (const SimEvent& event : simulation.getEvents()) eventCounts[static_cast<int>(event.type)]++;
+    simulation.clearEvents();
+
+    if (simulation.isOver()) {
+        const BirdPopulation& birds = simulation.getBirds();
+        recording.endTick = simulation.getTick();
+        recording.scores.assign(birds.getScore(), birds.getScore() + birds.size());
+    }
+    recordTickGap();
+}
+
+void SimThread::stepNet() {
+    if (session.update(simulation, netFlap, simClockNs())) {
+        netFlap = false;
+        appliedInputAt = acceptedInputAt;
+    }
+    if (session.isRunning()) netStatus = NetStatus::PLAYING;
+    // Events of ticks simulated again after a rollback are not repeated.
+    const int local = session.getLocalPlayer();
+    for (const SimEvent& event : simulation.getEvents())
+        if (event.type != SimEventType::FLAP || event.bird != local) eventCounts[static_cast<int>(event.type)]++;
+    simulation.clearEvents();
+
+    if (recording.endTick == 0 && session.isConfirmedOver(simulation)) {
+        const BirdPopulation& birds = simulation.getBirds();
+        recording.seed = session.getSeed();
+        recording.endTick = simulation.getTick();
+        recording.scores.assign(birds.getScore(), birds.getScore() + birds.size());
+        // Flaps confirmed past the end in this update change nothing. The
+        // main thread reads the recording once it sees the game over, so
+        // the session stops appending to it here.
+        const std::uint32_t end = recording.endTick;
+        recording.inputs.erase(std::remove_if(recording.inputs.begin(), recording.inputs.end(),
+                                              [end](const ReplayInput& input) { return input.tick >= end; }),
+                               recording.inputs.end());
+        session.setRecording(nullptr);
+    }
+}
+
+void SimThread::endNetGame() {
+    if (netStatus == NetStatus::OFF) return;
+    session.setRecording(nullptr);
+    session.close();
+    netStatus = NetStatus::OFF;
+}
+
+bool SimThread::ticking() const {
+    // A networked game keeps answering its peers after it ends, until it is left.
+    if (netStatus == NetStatus::WAITING || netStatus == NetStatus::PLAYING) return true;
+    return started && !simulation.isOver();
+}
+
+void SimThread::recordTickGap() {
+    const std::uint64_t now = simClockNs();
+    if (lastTickAt != 0) {
+        const std::uint64_t gap = now - lastTickAt;
+        if (gap > maxTickGapNs.load(std::memory_order_relaxed)) maxTickGapNs.store(gap, std::memory_order_relaxed);
+    }
+    lastTickAt = now;
+    tickCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void SimThread::publish() {
+    SimSnapshot& snapshot = snapshots.writeSlot();
+    const BirdPopulation& birds = simulation.getBirds();
+    snapshot.publishedAt = simClockNs();
+    snapshot.generation = generation;
+    snapshot.tick = simulation.getTick();
+    const bool net = netStatus != NetStatus::OFF;
+    snapshot.started = net ? session.isRunning() : started;
+    snapshot.over = net ? session.isConfirmedOver(simulation) : simulation.isOver();
+    snapshot.winner = simulation.getWinner();
+    snapshot.birdCount = 0;
+    snapshot.population = aiMode ? birds.size() : 0;
+    snapshot.populationAlive = 0;
+    snapshot.aiScore = 0;
+    snapshot.aiGeneration = aiMode ? evolution.getGeneration() : 0;
+    for (int i = 0; i < birds.size(); i++) {
+        // Players keep their slots; AI birds that have crashed are left out.
+        if (aiMode) {
+            snapshot.aiScore = std::max(snapshot.aiScore, birds.getScore()[i]);
+            if (!birds.isAlive(i) || birds.isCollided(i)) continue;
+            snapshot.populationAlive++;
+        }
+        if (snapshot.birdCount == SNAPSHOT_BIRDS) continue;
+        const int slot = snapshot.birdCount++;
+        snapshot.y[slot] = birds.getY()[i];
+        snapshot.prevY[slot] = birds.getPrevY()[i];
+        snapshot.velocity[slot] = birds.getVelocity()[i];
+        snapshot.birdX[slot] = simulation.getBirdX(i);
+        snapshot.alive[slot] = birds.isAlive(i);
+        snapshot.collided[slot] = birds.isCollided(i);
+        snapshot.score[slot] = birds.getScore()[i];
+    }
+    snapshot.inputAt = appliedInputAt;
+    snapshot.net = netStatus;
+    snapshot.localPlayer = net ? session.getLocalPlayer() : -1;
+    snapshot.pipeCount = 0;
+    for (const Pipe& pipe : simulation.getPipes()) snapshot.pipes[snapshot.pipeCount++] = pipe;
+    std::copy(eventCounts, eventCounts + SIM_EVENT_TYPES, snapshot.events);
+    snapshots.publish();
+}
+
+std::uint32_t SimThread::subTickAt(std::uint64_t inputAt) const {
+    // The next step simulates the tick that ends at nextTick. A key pressed
+    // before that tick began is late and lands at its start.
+    const std::uint64_t tickStart = toNs(nextTick - TICK_DURATION);
+    if (inputAt <= tickStart) return 0;
+    const std::uint64_t subTick = (inputAt - tickStart) * Constants::SUB_TICK_STEPS /
+                                  static_cast<std::uint64_t>(TICK_DURATION.count());
+    return static_cast<std::uint32_t>(std::min<std::uint64_t>(subTick, Constants::SUB_TICK_STEPS - 1));
+}
+
+bool SimThread::poll() {
+    return snapshots.update();
+}
+
+const SimSnapshot& SimThread::snapshot() const {
+    return snapshots.read();
+}
+
+const Replay& SimThread::getRecording() const {
+    return recording;
+}
+
+void SimThread::takeStats(std::uint64_t& ticks, double& maxTickGapMs) {
+    ticks = tickCount.exchange(0, std::memory_order_relaxed);
+    maxTickGapMs = static_cast<double>(maxTickGapNs.exchange(0, std::memory_order_relaxed)) / 1e6;
+}
+
+float snapshotAlpha(const SimSnapshot& snapshot) {
+    if (snapshot.over) return 1.0f;
+    const std::uint64_t now = simClockNs();
+    if (now <= snapshot.publishedAt) return 0.0f;
+    const float alpha = static_cast<float>(now - snapshot.publishedAt) / static_cast<float>(TICK_DURATION.count());
+    return std::min(alpha, 1.0f);
+}
@@ -0,0 +1,181 @@
+#ifndef SIMTHREAD_H
+#define SIMTHREAD_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include "constants.h"
+#include "neuroevolution.h"
+#include "planner.h"
+#include "replay.h"
+#include "rollback.h"
+#include "simulation.h"
+#include "spscqueue.h"
+#include "structs.h"
+#include "triplebuffer.h"
+
+// Most birds a snapshot carries: one or two players, or the first AI birds
+// still flying. The rest of a large population is simulated but not drawn.
+constexpr int SNAPSHOT_BIRDS = 256;
+constexpr int SIM_EVENT_TYPES = static_cast<int>(SimEventType::POINT) + 1;
+
+enum class NetStatus {
+    OFF,        // Ván chơi trên một máy
+    FAILED,     // Không mở được cổng UDP
+    WAITING,    // Đang chờ nghe thấy tất cả người chơi
+    PLAYING     // Ván qua mạng đang chạy
+};
+
+// Everything the main thread needs to draw and react to one tick.
+struct SimSnapshot {
+    std::uint64_t publishedAt = 0;  // Thời điểm công bố (ns, steady_clock)
+    std::uint32_t generation = 0;   // Ván nào (tăng mỗi lần reset)
+    std::uint32_t tick = 0;         // Số tick từ lúc bắt đầu ván
+    bool started = false;           // Ván đã bắt đầu chưa
+    bool over = false;              // Ván đã kết thúc chưa
+    int winner = -1;                // Người thắng ở chế độ 2 người, -1 nếu hòa
+    int birdCount = 0;
+    float y[SNAPSHOT_BIRDS] = {};
+    float prevY[SNAPSHOT_BIRDS] = {};
+    float velocity[SNAPSHOT_BIRDS] = {};
+    int birdX[SNAPSHOT_BIRDS] = {};
+    bool alive[SNAPSHOT_BIRDS] = {};
+    bool collided[SNAPSHOT_BIRDS] = {};
+    std::int32_t score[SNAPSHOT_BIRDS] = {};
+    int pipeCount = 0;
+    Pipe pipes[Constants::PIPE_CAPACITY];
+    std::uint64_t inputAt = 0;      // Thời điểm phím của cú vỗ cánh mới nhất đã được mô phỏng (ns)
+    // Số sự kiện theo SimEventType, cộng dồn từ đầu ván. Vỗ cánh do người
+    // chơi gửi không được đếm vì luồng chính đã tự phát âm thanh.
+    std::uint32_t events[SIM_EVENT_TYPES] = {};
+    int aiGeneration = 0;           // Thế hệ mạng nơ-ron hiện tại (chế độ chim AI)
+    int population = 0;             // Tổng số chim AI
+    int populationAlive = 0;        // Số chim AI còn đang bay
+    std::int32_t aiScore = 0;       // Điểm cao nhất trong thế hệ hiện tại
+    NetStatus net = NetStatus::OFF; // Trạng thái ván qua mạng
+    int localPlayer = -1;           // Người chơi trên máy này trong ván qua mạng, -1 nếu không có
+};
+
+enum class SimCommandType {
+    RESET,  // Chuẩn bị ván mới với seed và số chim
+    START,  // Bắt đầu chạy tick
+    FLAP,   // Chim vỗ cánh trước tick kế tiếp
+    STOP,   // Dừng ván, luồng ngủ cho tới lệnh tiếp theo
+    AI_BIRDS, // Cho một quần thể chim AI tự bay và tiến hóa qua từng thế hệ
+    AUTOPILOT, // Bật (value = ngân sách µs mỗi tick) hoặc tắt (0) chế độ tự lái cho chim 0
+    NET_GAME  // Mở ván qua mạng với rollback và bắt đầu ngay khi mọi người chơi đã kết nối
+};
+
+struct SimCommand {
+    SimCommandType type;
+    int value;                  // Số chim (RESET, AI_BIRDS) hoặc chỉ số chim (FLAP)
+    std::uint32_t seed;
+    std::uint32_t generation;
+    const Replay* playback;     // Replay được phát lại, hoặc nullptr
+    std::uint64_t inputAt = 0;  // Thời điểm bấm phím (FLAP, ns theo simClockNs)
+    const float* genome = nullptr;  // Mạng khởi đầu (AI_BIRDS), hoặc nullptr để khởi tạo ngẫu nhiên
+    const CollisionMasks* masks = nullptr;  // Mặt nạ va chạm (RESET, AI_BIRDS, NET_GAME), nullptr để chỉ xét hình hộp
+    const NetConfig* net = nullptr;         // Cấu hình ván qua mạng (NET_GAME)
+};
+
+// Runs the simulation on its own thread at a fixed tick rate, so a slow
+// frame on the main thread does not delay physics. Commands travel in over a
+// lock-free queue and snapshots come back through a triple buffer. While no
+// game is running the thread sleeps until the next command.
+class SimThread {
+private:
+    Simulation simulation;
+    Replay recording;
+    const Replay* playback = nullptr;
+    std::size_t playbackNext = 0;
+    std::uint32_t generation = 0;
+    std::uint32_t eventCounts[SIM_EVENT_TYPES] = {};
+    bool started = false;
+    // AI birds mode: the population flies itself and evolves between games.
+    Evolution evolution;
+    bool aiMode = false;
+    // Lookahead autopilot flying bird 0 when enabled.
+    Planner planner;
+    bool autopilot = false;
+    // Networked game: the session owns the simulation's ticks while it runs.
+    RollbackSession session;
+    NetStatus netStatus = NetStatus::OFF;
+    bool netFlap = false;
+    std::chrono::steady_clock::time_point nextTick;
+    // Key times of the latest accepted flap and of the latest one simulated.
+    std::uint64_t acceptedInputAt = 0;
+    std::uint64_t appliedInputAt = 0;
+
+    SpscQueue<SimCommand, 256> commands;
+    TripleBuffer<SimSnapshot> snapshots;
+
+    std::thread thread;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+    std::atomic<bool> stopping{false};
+
+    // Tick timing, read and reset by takeStats().
+    std::atomic<std::uint64_t> tickCount{0};
+    std::atomic<std::uint64_t> maxTickGapNs{0};
+    std::uint64_t lastTickAt = 0;
+
+    void run();
+    void send(const SimCommand& command);
+    // Returns whether a game was reset, started or stopped.
+    bool applyCommands();
+    void step();
+    void stepNet();
+    void endNetGame();
+    bool ticking() const;
+    void recordTickGap();
+    void publish();
+    std::uint32_t subTickAt(std::uint64_t inputAt) const;
+
+public:
+    SimThread();
+    ~SimThread();
+    SimThread(const SimThread&) = delete;
+    SimThread& operator=(const SimThread&) = delete;
+
+    // masks switches the game to pixel collision and must outlive it.
+    void reset(int players, std::uint32_t seed, std::uint32_t gameGeneration, const Replay* replay,
+               const CollisionMasks* masks);
+    void start();
+    // inputAt is when the key was pressed on simClockNs(); the flap lands at
+    // that point within the tick being simulated, or at its start if later.
+    void flap(int bird, std::uint64_t inputAt);
+    void stop();
+    // Starts a population of neural network birds that plays and evolves on
+    // its own until the next reset. genome seeds the first generation if not
+    // nullptr and must outlive the call's processing.
+    void startAi(int population, std::uint32_t gameGeneration, const float* genome, const CollisionMasks* masks);
+    // Lets the planner fly bird 0 of every game with budgetUs microseconds
+    // per tick to decide, or hands it back to the player if budgetUs is 0.
+    // Its flaps are recorded like the player's.
+    void setAutopilot(int budgetUs);
+    // Starts a rollback game over UDP as configured. It begins once every
+    // player has been heard from and ticks until the next command that ends
+    // it; flap() then only takes the local player's bird. config is copied
+    // when the command is processed and must not change before that.
+    void startNet(const NetConfig* config, std::uint32_t gameGeneration, const CollisionMasks* masks);
+
+    // Swaps in the newest snapshot. Returns true if there was one.
+    bool poll();
+    const SimSnapshot& snapshot() const;
+    // The finished game's inputs, seed and result. Only valid once the
+    // current generation's snapshot reports it is over.
+    const Replay& getRecording() const;
+    void takeStats(std::uint64_t& ticks, double& maxTickGapMs);
+};
+
+// Nanoseconds on the steady clock the simulation thread schedules ticks with.
+std::uint64_t simClockNs();
+
+// Fraction of a tick elapsed since the snapshot was published, for
+// interpolating between its previous and current positions.
+float snapshotAlpha(const SimSnapshot& snapshot);
+
+#endif // SIMTHREAD_H
@@ -0,0 +1,246 @@
+#include "simulation.h"
+#include <algorithm>
+#include "profiler.h"
+
+Simulation::Simulation(unsigned seed) : rng(seed) {}
+
+void Simulation::seed(unsigned value) {
+    rng.seed(value);
+}
+
+void Simulation::setCollisionMasks(const CollisionMasks* collisionMasks) {
+    masks = collisionMasks;
+}
+
+void Simulation::reset(int players) {
+    birds.reset(players, Constants::WINDOW_HEIGHT / 2.0f);
+    // Birds are split into contiguous runs, one per column, so each column can
+    // be tested against a pipe in a single pass.
+    columnCount = std::min(players, Constants::BIRD_COLUMNS);
+    for (int c = 0; c <= columnCount; c++)
+        columnStart[c] = columnCount > 0 ? c * players / columnCount : 0;
+    pipes.clear();
+    events.clear();
+    // A tick can flap, score, hit and fall every bird, so a large population
+    // never grows the event list mid-game.
+    events.reserve(static_cast<std::size_t>(players) * 4);
+    pendingFlaps.clear();
+    pendingFlaps.reserve(players);
+    tick = 0;
+    winner = -1;
+    over = false;
+}
+
+void Simulation::start() {
+    birds.revive();
+    tick = 0;
+    winner = -1;
+    over = false;
+    pipes.push_back(Pipe(Constants::WINDOW_WIDTH, randomGapY(50)));
+}
+
+bool Simulation::flap(int bird, float phase) {
+    if (bird < 0 || bird >= birds.size()) return false;
+    if (!birds.isAlive(bird) || birds.isCollided(bird)) return false;
+    if (phase <= 0.0f) {
+        birds.getVelocity()[bird] = Constants::FLAP_VELOCITY;
+    } else {
+        for (const PendingFlap& pending : pendingFlaps)
+            if (pending.bird == bird) return false;
+        pendingFlaps.push_back({bird, std::min(phase, 1.0f)});
+    }
+    events.push_back({SimEventType::FLAP, bird});
+    return true;
+}
+
+void Simulation::step() {
+    birds.savePositions();
+    for (auto& pipe : pipes) pipe.prevX = pipe.x;
+    if (over) return;
+
+    tick++;
+    applyPendingFlaps();
+    updateBirdPhysics();
+    updatePipes();
+    spawnPipe();
+
+    const std::int32_t* alive = birds.getAlive();
+    if (std::none_of(alive, alive + birds.size(), [](std::int32_t a) { return a != 0; }))
+        updateGameOver();
+}
+
+void Simulation::clearEvents() {
+    events.clear();
+}
+
+void Simulation::saveState(SimState& state) const {
+    state.birds = birds;
+    state.pipes = pipes;
+    state.rng = rng;
+    state.tick = tick;
+    state.winner = winner;
+    state.over = over;
+}
+
+void Simulation::loadState(const SimState& state) {
+    birds = state.birds;
+    pipes = state.pipes;
+    rng = state.rng;
+    tick = state.tick;
+    winner = state.winner;
+    over = state.over;
+    pendingFlaps.clear();
+    events.clear();
+}
+
+void Simulation::applyPendingFlaps() {
+    // The bird keeps its old velocity until the flap and moves at the flap
+    // velocity after it. Position and velocity are set up so that the regular
+    // integration step below lands on that result.
+    float* y = birds.getY();
+    float* velocity = birds.getVelocity();
+    for (const PendingFlap& pending : pendingFlaps) {
+        const float before = velocity[pending.bird] + Constants::GRAVITY;
+        const float after = Constants::FLAP_VELOCITY + (1.0f - pending.phase) * Constants::GRAVITY;
+        y[pending.bird] += pending.phase * (before - after);
+        velocity[pending.bird] = Constants::FLAP_VELOCITY - pending.phase * Constants::GRAVITY;
+    }
+    pendingFlaps.clear();
+}
+
+void Simulation::updateBirdPhysics() {
+    PROFILE_ZONE("updateBirdPhysics");
+    if (birds.integrate() == 0) return;
+
+    // A bird that already hit a pipe dies on the ground; one that did not just fell.
+    const std::int32_t* landed = birds.getLanded();
+    const std::int32_t* collided = birds.getCollided();
+    for (int i = 0; i < birds.size(); i++) {
+        if (landed[i])
+            events.push_back({collided[i] ? SimEventType::DIE : SimEventType::FALL, i});
+    }
+}
+
+void Simulation::updatePipes() {
+    PROFILE_ZONE("updatePipes");
+    // A pipe scores for every living bird on the tick its right edge crosses the scoring line.
+    const int scoreLine = Constants::WINDOW_WIDTH / 4;
+    int scoredPipes = 0;
+    for (auto& pipe : pipes) {
+        const int right = pipe.x + Constants::PIPE_WIDTH;
+        pipe.x -= Constants::PIPE_SPEED;
+        if (right >= scoreLine && right - Constants::PIPE_SPEED < scoreLine) scoredPipes++;
+    }
+    while (!pipes.empty() && pipes.front().x + Constants::PIPE_WIDTH < 0) pipes.pop_front();
+
+    for (int c = 0; c < columnCount; c++) collideColumn(c);
+
+    const std::int32_t* alive = birds.getAlive();
+    std::int32_t* score = birds.getScore();
+    for (; scoredPipes > 0; scoredPipes--) {
+        for (int i = 0; i < birds.size(); i++) {
+            if (alive[i]) {
+                score[i]++;
+                events.push_back({SimEventType::POINT, i});
+            }
+        }
+    }
+}
+
+void Simulation::collideColumn(int column) {
+    // Pipes are sorted by x, so only the run of pipes overlapping this column is tested.
+    const int left = getBirdX(columnStart[column]);
+    const int right = left + Constants::BIRD_SIZE;
+    const int begin = columnStart[column];
+    const int end = columnStart[column + 1];
+    for (const Pipe& pipe : pipes) {
+        if (pipe.x >= right) break;
+        if (pipe.x + Constants::PIPE_WIDTH <= left) continue;
+        const int gapTop = pipe.gapY - Constants::PIPE_GAP / 2;
+        const int gapBottom = pipe.gapY + Constants::PIPE_GAP / 2;
+        if (birds.collideGap(begin, end, gapTop, gapBottom) == 0) continue;
+        const std::int32_t* hit = birds.getHit();
+        if (masks) {
+            // Player 2 has its own sprite; every other bird is drawn as player 1.
+            for (int i = begin; i < end; i++) {
+                if (!hit[i]) continue;
+                const CollisionMask& bird = masks->birds[birds.size() == 2 && i == 1 ? 1 : 0];
+                if (!pixelsOverlap(bird, left, static_cast<int>(birds.getY()[i]), *masks, pipe.x, gapTop, gapBottom))
+                    birds.clearHit(i);
+            }
+        }
+        for (int i = begin; i < end; i++)
+            if (hit[i]) events.push_back({SimEventType::HIT, i});
+    }
+}
+
+void Simulation::spawnPipe() {
+    if (pipes.empty() || (Constants::WINDOW_WIDTH - pipes.back().x >= Constants::PIPE_SPACING + Constants::PIPE_WIDTH))
+        pipes.push_back(Pipe(Constants::WINDOW_WIDTH, randomGapY(75)));
+}
+
+void Simulation::updateGameOver() {
+    over = true;
+    winner = -1;
+    if (birds.size() < 2) return;
+    const std::int32_t* score = birds.getScore();
+    int best = 0;
+    for (int i = 1; i < birds.size(); i++)
+        if (score[i] > score[best]) best = i;
+    for (int i = 0; i < birds.size(); i++)
+        if (i != best && score[i] == score[best]) return;
+    winner = best;
+}
+
+int Simulation::randomGapY(int margin) {
+    return static_cast<int>(rng() % (Constants::WINDOW_HEIGHT - Constants::PIPE_GAP - 2 * margin)) + margin;
+}
+
+bool Simulation::isOver() const {
+    return over;
+}
+
+std::uint32_t Simulation::getTick() const {
+    return tick;
+}
+
+int Simulation::getWinner() const {
+    return winner;
+}
+
+int Simulation::getBirdX(int bird) const {
+    int column = 0;
+    while (column + 1 < columnCount && bird >= columnStart[column + 1]) column++;
+    return Constants::WINDOW_WIDTH / 4 + column * Constants::BIRD_SPACING;
+}
+
+const BirdPopulation& Simulation::getBirds() const {
+    return birds;
+}
+
+const PipeQueue& Simulation::getPipes() const {
+    return pipes;
+}
+
+const std::vector<SimEvent>& Simulation::getEvents() const {
+    return events;
+}
+
+const Pipe* Simulation::nextPipe(int x) const {
+    for (const Pipe& pipe : pipes)
+        if (pipe.x + Constants::PIPE_WIDTH >= x) return &pipe;
+    return nullptr;
+}
+
+BirdObservation Simulation::observe(int bird, const Pipe* next) const {
+    const float height = static_cast<float>(Constants::WINDOW_HEIGHT);
+    const float width = static_cast<float>(Constants::WINDOW_WIDTH);
+    const float y = birds.getY()[bird];
+    const int gapY = next ? next->gapY : Constants::WINDOW_HEIGHT / 2;
+    BirdObservation observation;
+    observation.y = y / height;
+    observation.velocity = birds.getVelocity()[bird] / -Constants::FLAP_VELOCITY;
+    observation.pipeDistance = next ? (next->x + Constants::PIPE_WIDTH - getBirdX(bird)) / width : 1.0f;
+    observation.gapOffset = (gapY - (y + Constants::BIRD_SIZE / 2.0f)) / height;
+    return observation;
+}
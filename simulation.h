@@ -0,0 +1,114 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <cstdint>
+#include <random>
+#include <vector>
+#include "constants.h"
+#include "structs.h"
+#include "birdpopulation.h"
+#include "collisionmask.h"
+#include "pipequeue.h"
+
+// Game rules without any SDL dependency. Sounds and other side effects are
+// reported as SimEvent records instead of being played directly.
+enum class SimEventType {
+    FLAP,   // Bird flapped
+    HIT,    // Bird hit a pipe
+    FALL,   // Bird hit the ground without touching a pipe
+    DIE,    // Bird that hit a pipe reached the ground
+    POINT   // Bird passed a pipe
+};
+
+struct SimEvent {
+    SimEventType type;
+    int bird;
+};
+
+// Everything a game changes as it runs, taken between two steps. Saving into
+// a state that already held as many birds copies the arrays without
+// allocating, so a ring of these makes rollback cheap.
+struct SimState {
+    BirdPopulation birds;
+    PipeQueue pipes;
+    std::minstd_rand rng;
+    std::uint32_t tick = 0;
+    int winner = -1;
+    bool over = false;
+};
+
+// What a learned policy sees of one bird. Evolved genomes and VecEnv agents
+// are trained on these exact values, so both take them from here.
+struct BirdObservation {
+    float y;            // Height, 0 at the top of the window and 1 at the bottom
+    float velocity;     // In flap velocities, positive when rising
+    float pipeDistance; // To the right edge of the next pipe, in window widths
+    float gapOffset;    // From the bird's centre to the gap, in window heights; positive below
+};
+
+class Simulation {
+private:
+    // A flap that lands part-way through the next tick.
+    struct PendingFlap {
+        int bird;
+        float phase;
+    };
+
+    BirdPopulation birds;
+    PipeQueue pipes;
+    std::vector<SimEvent> events;
+    std::vector<PendingFlap> pendingFlaps;
+    int columnStart[Constants::BIRD_COLUMNS + 1] = {};
+    int columnCount = 0;
+    std::minstd_rand rng;
+    const CollisionMasks* masks = nullptr;
+    std::uint32_t tick = 0;
+    int winner = -1;
+    bool over = false;
+
+    void applyPendingFlaps();
+    void updateBirdPhysics();
+    void updatePipes();
+    void collideColumn(int column);
+    void spawnPipe();
+    void updateGameOver();
+    int randomGapY(int margin);
+
+public:
+    explicit Simulation(unsigned seed = std::minstd_rand::default_seed);
+
+    void seed(unsigned value);
+    // Birds whose box touches a pipe only hit it if their opaque pixels do.
+    // nullptr tests boxes alone. The masks must outlive their use; the
+    // setting is kept across resets.
+    void setCollisionMasks(const CollisionMasks* collisionMasks);
+    void reset(int players);
+    void start();
+    // phase is when in the next tick the flap happens, from 0 (its start) to
+    // 1 (its end). A bird flaps at most once per tick unless phase is 0.
+    bool flap(int bird, float phase = 0.0f);
+    void step();
+    void clearEvents();
+    // The player count and collision masks are not part of the state; a
+    // state can only be loaded into a simulation reset for as many players.
+    // Loading drops pending flaps and events.
+    void saveState(SimState& state) const;
+    void loadState(const SimState& state);
+
+    bool isOver() const;
+    // Steps taken since start(); a flap made now takes effect in step number getTick().
+    std::uint32_t getTick() const;
+    int getWinner() const;
+    int getBirdX(int bird) const;
+    const BirdPopulation& getBirds() const;
+    const PipeQueue& getPipes() const;
+    const std::vector<SimEvent>& getEvents() const;
+
+    // The first pipe whose right edge is not yet behind x, or nullptr.
+    const Pipe* nextPipe(int x) const;
+    // next is nextPipe() of the bird's column; birds in one column share it.
+    // With no pipe ahead yet, the bird sees a centred gap a window away.
+    BirdObservation observe(int bird, const Pipe* next) const;
+};
+
+#endif // SIMULATION_H
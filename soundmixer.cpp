@@ -0,0 +1,134 @@
+#include "soundmixer.h"
+#include "capture.h"
+#include "constants.h"
+
+namespace {
+
+// Indexed by Sound. Impacts and UI feedback outrank the constant stream of flaps.
+constexpr int PRIORITY[] = {
+    3,  // DIE
+    3,  // HIT
+    2,  // POINT
+    1,  // WING
+    3,  // CLICK
+    3   // FALLING
+};
+static_assert(sizeof(PRIORITY) / sizeof(PRIORITY[0]) == static_cast<int>(Sound::COUNT), "one priority per Sound");
+
+constexpr int BASE_VOLUME = MIX_MAX_VOLUME * 3 / 4;
+
+}
+
+bool SoundMixer::open(int samples) {
+    if (Mix_OpenAudio(Constants::AUDIO_FREQUENCY, MIX_DEFAULT_FORMAT, Constants::AUDIO_CHANNELS, samples) < 0)
+        return false;
+    Uint16 format;
+    int channels;
+    Mix_QuerySpec(&frequency, &format, &channels);
+    bufferSamples = samples;
+    // Reserved channels are never picked by Mix_PlayChannel(-1), so only this pool uses them.
+    Mix_AllocateChannels(VOICES);
+    Mix_ReserveChannels(VOICES);
+    Mix_SetPostMix(&SoundMixer::postMix, this);
+    SDL_Log("Audio opened with %d-sample buffers (%.1f ms)", samples, samples * 1000.0 / frequency);
+    return true;
+}
+
+void SoundMixer::close() {
+    if (bufferSamples == 0) return;
+    Mix_SetPostMix(nullptr, nullptr);
+    Mix_CloseAudio();
+    bufferSamples = 0;
+}
+
+void SoundMixer::attach(Mix_Chunk* const sounds[]) {
+    chunks = sounds;
+}
+
+void SoundMixer::setCapture(GameCapture* gameCapture) {
+    capture.store(gameCapture);
+}
+
+void SoundMixer::queue(Sound sound, int count) {
+    pending[static_cast<int>(sound)] += count;
+}
+
+void SoundMixer::markInput(Uint32 eventTicks) {
+    inputTicks = eventTicks;
+    inputMarked = true;
+}
+
+void SoundMixer::flush() {
+    for (int i = 0; i < SOUND_COUNT; i++) {
+        if (pending[i] == 0) continue;
+        play(static_cast<Sound>(i), pending[i]);
+        pending[i] = 0;
+    }
+    inputMarked = false;
+}
+
+void SoundMixer::play(Sound sound, int count) {
+    Mix_Chunk* chunk = chunks ? chunks[static_cast<int>(sound)] : nullptr;
+    if (!chunk || bufferSamples == 0) return;
+    const int priority = PRIORITY[static_cast<int>(sound)];
+    const int channel = pickVoice(priority);
+    if (channel < 0) {
+        dropped++;
+        return;
+    }
+    // Each extra copy closes a share of the gap to full volume: 1 -> 3/4, 2 -> 7/8, 4 -> 15/16, ...
+    const int volume = MIX_MAX_VOLUME - (MIX_MAX_VOLUME - BASE_VOLUME) / count;
+    Mix_Volume(channel, volume);
+    if (Mix_PlayChannel(channel, chunk, 0) < 0) return;
+    voices[channel] = {sound, priority, ++playCounter};
+
+    if (inputMarked && probeStart.load(std::memory_order_relaxed) == 0) {
+        // Event timestamps are in SDL_GetTicks milliseconds; move the start back by the input delay.
+        const Uint64 frequencyHz = SDL_GetPerformanceFrequency();
+        const Uint64 inputDelay = static_cast<Uint64>(SDL_GetTicks() - inputTicks) * frequencyHz / 1000;
+        probeStart.store(SDL_GetPerformanceCounter() - inputDelay, std::memory_order_release);
+    }
+}
+
+int SoundMixer::pickVoice(int priority) {
+    int victim = -1;
+    for (int channel = 0; channel < VOICES; channel++) {
+        if (!Mix_Playing(channel)) return channel;
+        const Voice& voice = voices[channel];
+        if (voice.priority > priority) continue;
+        if (victim < 0 || voice.priority < voices[victim].priority ||
+            (voice.priority == voices[victim].priority && voice.startedAt < voices[victim].startedAt))
+            victim = channel;
+    }
+    if (victim >= 0) Mix_HaltChannel(victim);
+    return victim;
+}
+
+void SoundMixer::postMix(void* self, Uint8* stream, int length) {
+    // Runs on the audio thread once a buffer is mixed; it is heard one buffer later.
+    SoundMixer* mixer = static_cast<SoundMixer*>(self);
+    if (GameCapture* capture = mixer->capture.load(std::memory_order_acquire)) capture->pushAudio(stream, length);
+    const Uint64 start = mixer->probeStart.exchange(0, std::memory_order_acq_rel);
+    if (start == 0) return;
+    const Uint64 frequencyHz = SDL_GetPerformanceFrequency();
+    const Uint64 mixedUs = (SDL_GetPerformanceCounter() - start) * 1000000 / frequencyHz;
+    const Uint64 latencyUs = mixedUs + static_cast<Uint64>(mixer->bufferSamples) * 1000000 / mixer->frequency;
+    mixer->latencySumUs.fetch_add(latencyUs, std::memory_order_relaxed);
+    Uint64 previousMax = mixer->latencyMaxUs.load(std::memory_order_relaxed);
+    while (latencyUs > previousMax &&
+           !mixer->latencyMaxUs.compare_exchange_weak(previousMax, latencyUs, std::memory_order_relaxed)) {}
+    mixer->latencySamples.fetch_add(1, std::memory_order_relaxed);
+}
+
+int SoundMixer::getBufferSamples() const {
+    return bufferSamples;
+}
+
+void SoundMixer::logStats() const {
+    const int samples = latencySamples.load(std::memory_order_relaxed);
+    if (samples > 0) {
+        SDL_Log("Input-to-sound latency over %d effects with %d-sample buffers: avg %.1f ms, max %.1f ms",
+                samples, bufferSamples, latencySumUs.load() / 1000.0 / samples, latencyMaxUs.load() / 1000.0);
+    }
+    if (dropped > 0) SDL_Log("%d sound effects dropped because every voice was busy", dropped);
+}
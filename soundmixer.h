@@ -0,0 +1,75 @@
+#ifndef SOUNDMIXER_H
+#define SOUNDMIXER_H
+
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <atomic>
+#include "structs.h"
+
+class GameCapture;
+
+// Plays sound effects on a fixed pool of reserved mixer channels.
+//
+// Effects are queued during a tick and played by flush(): several requests
+// for the same effect in one tick become one voice whose volume grows with
+// the count. When every voice is busy, a new effect replaces the oldest voice
+// of lower or equal priority, or is dropped if all voices outrank it.
+//
+// It also measures flap-to-sound latency: from the input event that caused
+// an effect to the end of the first mixed buffer containing it.
+class SoundMixer {
+private:
+    static constexpr int VOICES = 16;
+    static constexpr int SOUND_COUNT = static_cast<int>(Sound::COUNT);
+
+    struct Voice {
+        Sound sound = Sound::CLICK;
+        int priority = -1;
+        Uint64 startedAt = 0;
+    };
+
+    Mix_Chunk* const* chunks = nullptr;
+    Voice voices[VOICES];
+    int pending[SOUND_COUNT] = {};
+    int bufferSamples = 0;
+    int frequency = 0;
+    Uint64 playCounter = 0;
+    int dropped = 0;
+
+    // Latency probe, completed by the mixer thread.
+    Uint32 inputTicks = 0;
+    bool inputMarked = false;
+    std::atomic<Uint64> probeStart{0};
+    std::atomic<Uint64> latencySumUs{0};
+    std::atomic<Uint64> latencyMaxUs{0};
+    std::atomic<int> latencySamples{0};
+
+    // Receives every mixed buffer while the game is being captured.
+    std::atomic<GameCapture*> capture{nullptr};
+
+    static void postMix(void* self, Uint8* stream, int length);
+    void play(Sound sound, int count);
+    int pickVoice(int priority);
+
+public:
+    SoundMixer() = default;
+    SoundMixer(const SoundMixer&) = delete;
+    SoundMixer& operator=(const SoundMixer&) = delete;
+
+    // Opens the audio device with the given buffer size in sample frames.
+    bool open(int samples);
+    void close();
+    // chunks[i] is the effect for Sound i and may be null until it is loaded.
+    void attach(Mix_Chunk* const chunks[]);
+    void setCapture(GameCapture* gameCapture);
+
+    void queue(Sound sound, int count = 1);
+    // Ties the next flushed effect to an input event (SDL event timestamp).
+    void markInput(Uint32 eventTicks);
+    void flush();
+
+    int getBufferSamples() const;
+    void logStats() const;
+};
+
+#endif // SOUNDMIXER_H
@@ -0,0 +1,114 @@
+// Follows a running game's telemetry and prints a line of live stats every
+// second. Start the game with --telemetry NAME, then run:
+// spectate [name]
+// It waits for the game if it is not running yet and follows the next game
+// when it exits.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "structs.h"
+#include "telemetry.h"
+
+namespace {
+
+constexpr std::chrono::milliseconds POLL_INTERVAL(5);
+constexpr std::chrono::seconds REPORT_INTERVAL(1);
+
+const char* stateName(std::int32_t state) {
+    switch (static_cast<GameState>(state)) {
+        case GameState::MENU: return "menu";
+        case GameState::ONE_PLAYER: return "1 player";
+        case GameState::TWO_PLAYER: return "2 players";
+        case GameState::INFO: return "info";
+        case GameState::TWO_PLAYER_WAITING: return "2 players, waiting";
+        case GameState::ONE_PLAYER_WAITING: return "1 player, waiting";
+        case GameState::AI_BIRDS: return "AI birds";
+    }
+    return "?";
+}
+
+// Totals over one report interval.
+struct Interval {
+    long long frames = 0;
+    double frameMsSum = 0.0;
+    float frameMsMax = 0.0f;
+    double workMsSum = 0.0;
+    float workMsMax = 0.0f;
+    double publishUsSum = 0.0;
+    std::uint32_t firstTick = 0;
+    std::uint32_t lastTick = 0;
+};
+
+void report(const Interval& interval, const TelemetryFrame& frame, std::uint64_t skipped, double seconds) {
+    const double frames = static_cast<double>(std::max(interval.frames, 1LL));
+    std::printf("%-18s | %5.1f fps, frame %5.2f ms avg %6.2f max, work %5.2f avg %6.2f max, publish %4.2f us"
+                " | %5.1f ticks/s",
+                stateName(frame.gameState), interval.frames / seconds, interval.frameMsSum / frames,
+                interval.frameMsMax, interval.workMsSum / frames, interval.workMsMax, interval.publishUsSum / frames,
+                (interval.lastTick - interval.firstTick) / seconds);
+    if (frame.gameState == static_cast<std::int32_t>(GameState::AI_BIRDS)) {
+        std::printf(" | %d of %d birds flying", frame.populationAlive, frame.population);
+    } else if (frame.started) {
+        std::printf(" | tick %u, scores", frame.tick);
+        for (int i = 0; i < frame.birdCount; i++)
+            std::printf(" %d%s", frame.birds[i].score, frame.birds[i].alive ? "" : "x");
+        if (frame.over) std::printf(", over");
+    }
+    std::printf(" | %llu frames missed\n", static_cast<unsigned long long>(skipped));
+    std::fflush(stdout);
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    const char* name = argc > 1 ? argv[1] : TELEMETRY_DEFAULT_NAME;
+    if (argc > 2) {
+        std::fprintf(stderr, "Usage: %s [name]\n", argv[0]);
+        return 1;
+    }
+    using Clock = std::chrono::steady_clock;
+    TelemetryReader reader;
+    TelemetryFrame frame;
+    bool waiting = false;
+    for (;;) {
+        if (!reader.opened() || !reader.live()) {
+            if (reader.opened() || !waiting) {
+                std::printf("Waiting for a game publishing telemetry as %s...\n", name);
+                std::fflush(stdout);
+            }
+            reader.close();
+            waiting = true;
+            if (!reader.open(name)) {
+                std::this_thread::sleep_for(REPORT_INTERVAL);
+                continue;
+            }
+            waiting = false;
+            std::printf("Following %s\n", name);
+            std::fflush(stdout);
+        }
+
+        Interval interval;
+        std::uint64_t skipped = 0;
+        bool any = false;
+        const Clock::time_point start = Clock::now();
+        while (Clock::now() - start < REPORT_INTERVAL && reader.live()) {
+            while (reader.next(frame, skipped)) {
+                if (!any) interval.firstTick = frame.tick;
+                any = true;
+                interval.frames++;
+                interval.frameMsSum += frame.frameMs;
+                interval.frameMsMax = std::max(interval.frameMsMax, frame.frameMs);
+                interval.workMsSum += frame.workMs;
+                interval.workMsMax = std::max(interval.workMsMax, frame.workMs);
+                interval.publishUsSum += frame.publishUs;
+                interval.lastTick = frame.tick;
+            }
+            std::this_thread::sleep_for(POLL_INTERVAL);
+        }
+        // An idle screen only renders when something changes.
+        if (!any && reader.latest(frame)) interval.firstTick = interval.lastTick = frame.tick;
+        if (any || reader.latest(frame))
+            report(interval, frame, skipped, std::chrono::duration<double>(Clock::now() - start).count());
+    }
+}
@@ -0,0 +1,160 @@
+#include "spriteatlas.h"
+#include <SDL_image.h>
+#include <algorithm>
+#include <cstdint>
+#include "constants.h"
+
+namespace {
+
+constexpr int MIN_ATLAS_WIDTH = 256;
+constexpr int MAX_ATLAS_WIDTH = 4096;
+constexpr int ATLAS_PADDING = 2;
+constexpr int MAX_SPRITES = static_cast<int>(Sprite::COUNT);
+
+// Samples an ARGB8888 surface to a width x height mask.
+bool maskFromSurface(SDL_Surface* surface, int width, int height, CollisionMask& mask) {
+    if (!surface || surface->format->format != SDL_PIXELFORMAT_ARGB8888 || SDL_LockSurface(surface) != 0) return false;
+    const bool built = mask.build(static_cast<const std::uint32_t*>(surface->pixels), surface->w, surface->h,
+                                  surface->pitch / 4, width, height);
+    SDL_UnlockSurface(surface);
+    return built;
+}
+
+// Shelf-packs the surfaces, tallest first, into rows of the given width.
+// Returns the power-of-two height needed, or 0 if a sprite is wider than the atlas.
+int packShelves(SDL_Surface* const surfaces[], const int order[], int count, int width, SDL_Rect rects[]) {
+    int penX = 0, penY = 0, shelfH = 0;
+    for (int k = 0; k < count; k++) {
+        const int i = order[k];
+        const int w = surfaces[i]->w, h = surfaces[i]->h;
+        if (w > width) return 0;
+        if (penX + w > width) {
+            penX = 0;
+            penY += shelfH + ATLAS_PADDING;
+            shelfH = 0;
+        }
+        rects[i] = {penX, penY, w, h};
+        penX += w + ATLAS_PADDING;
+        shelfH = std::max(shelfH, h);
+    }
+    int height = 1;
+    while (height < penY + shelfH) height *= 2;
+    return height;
+}
+
+}
+
+SDL_Surface* SpriteAtlas::decode(const SpriteSource& source) {
+    SDL_Surface* loaded = IMG_Load(source.file);
+    if (!loaded) return nullptr;
+    SDL_Surface* surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(loaded);
+    if (!surface) return nullptr;
+
+    if (source.shrink > 1) {
+        SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, surface->w / source.shrink,
+            surface->h / source.shrink, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (scaled) {
+            SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+            SDL_BlitScaled(surface, nullptr, scaled, nullptr);
+        }
+        SDL_FreeSurface(surface);
+        surface = scaled;
+        if (!surface) return nullptr;
+    }
+
+    if (source.rotated) {
+        // A 180 degree rotation reverses the pixel order of the whole image.
+        for (int y = 0; y < (surface->h + 1) / 2; y++) {
+            Uint32* top = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+            Uint32* bottom = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) +
+                                                       (surface->h - 1 - y) * surface->pitch);
+            const int count = (top == bottom) ? surface->w / 2 : surface->w;
+            for (int x = 0; x < count; x++) std::swap(top[x], bottom[surface->w - 1 - x]);
+        }
+    }
+    return surface;
+}
+
+bool SpriteAtlas::collisionMasks(SDL_Surface* const surfaces[], CollisionMasks& masks) {
+    // Pipes keep their image height and are stretched to the gap when tested.
+    SDL_Surface* pipe = surfaces[static_cast<int>(Sprite::PIPE)];
+    SDL_Surface* pipeFlipped = surfaces[static_cast<int>(Sprite::PIPE_FLIPPED)];
+    return maskFromSurface(surfaces[static_cast<int>(Sprite::PLAYER1)], Constants::BIRD_SIZE, Constants::BIRD_SIZE, masks.birds[0]) &&
+           maskFromSurface(surfaces[static_cast<int>(Sprite::PLAYER2)], Constants::BIRD_SIZE, Constants::BIRD_SIZE, masks.birds[1]) &&
+           pipe && maskFromSurface(pipe, Constants::PIPE_WIDTH, pipe->h, masks.pipe) &&
+           pipeFlipped && maskFromSurface(pipeFlipped, Constants::PIPE_WIDTH, pipeFlipped->h, masks.pipeFlipped);
+}
+
+SpriteAtlas::~SpriteAtlas() {
+    destroy();
+}
+
+bool SpriteAtlas::build(SDL_Renderer* renderer, const Sprite sprites[], SDL_Surface* const surfaces[], int count) {
+    destroy();
+    bool ok = count <= MAX_SPRITES;
+    for (int i = 0; i < count && ok; i++) ok = surfaces[i] != nullptr;
+
+    // Pick the power-of-two width that wastes the least texture memory.
+    SDL_Rect packed[MAX_SPRITES] = {};
+    if (ok) {
+        int order[MAX_SPRITES];
+        for (int i = 0; i < count; i++) order[i] = i;
+        std::sort(order, order + count, [&](int a, int b) { return surfaces[a]->h > surfaces[b]->h; });
+        long long bestArea = 0;
+        SDL_Rect candidate[MAX_SPRITES];
+        for (int width = MIN_ATLAS_WIDTH; width <= MAX_ATLAS_WIDTH; width *= 2) {
+            const int height = packShelves(surfaces, order, count, width, candidate);
+            if (height == 0 || height > MAX_ATLAS_WIDTH) continue;
+            const long long area = static_cast<long long>(width) * height;
+            if (bestArea == 0 || area < bestArea) {
+                bestArea = area;
+                atlasW = width;
+                atlasH = height;
+                std::copy(candidate, candidate + count, packed);
+            }
+        }
+        ok = bestArea > 0;
+
+        SDL_RendererInfo info;
+        if (ok && SDL_GetRendererInfo(renderer, &info) == 0 && info.max_texture_width > 0 &&
+            (atlasW > info.max_texture_width || atlasH > info.max_texture_height)) {
+            SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Sprite atlas %dx%d exceeds the renderer limit %dx%d",
+                         atlasW, atlasH, info.max_texture_width, info.max_texture_height);
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, atlasW, atlasH, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (atlas) {
+            for (int i = 0; i < count; i++) {
+                SDL_SetSurfaceBlendMode(surfaces[i], SDL_BLENDMODE_NONE);
+                SDL_BlitSurface(surfaces[i], nullptr, atlas, &packed[i]);
+                rects[static_cast<int>(sprites[i])] = packed[i];
+            }
+            texture = SDL_CreateTextureFromSurface(renderer, atlas);
+            SDL_FreeSurface(atlas);
+        }
+        ok = texture != nullptr;
+        if (ok) SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+    }
+
+    for (int i = 0; i < count; i++) SDL_FreeSurface(surfaces[i]);
+    return ok;
+}
+
+void SpriteAtlas::destroy() {
+    SDL_DestroyTexture(texture);
+    texture = nullptr;
+    for (SDL_Rect& rect : rects) rect = {0, 0, 0, 0};
+}
+
+bool SpriteAtlas::contains(Sprite sprite) const {
+    return texture && rects[static_cast<int>(sprite)].w > 0;
+}
+
+void SpriteAtlas::draw(RenderBatch& batch, Sprite sprite, const SDL_FRect& dst) const {
+    if (!contains(sprite)) return;
+    batch.addQuad(texture, atlasW, atlasH, rects[static_cast<int>(sprite)], dst);
+}
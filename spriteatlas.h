@@ -0,0 +1,56 @@
+#ifndef SPRITEATLAS_H
+#define SPRITEATLAS_H
+
+#include <SDL.h>
+#include "collisionmask.h"
+#include "renderbatch.h"
+
+enum class Sprite {
+    BACKGROUND,
+    LOGO,
+    PIPE,
+    PIPE_FLIPPED,   // Ống quay 180 độ, dùng cho ống phía trên
+    PLAYER1,
+    PLAYER2,
+    SPEAKER_ON,
+    SPEAKER_OFF,
+    COUNT
+};
+
+struct SpriteSource {
+    const char* file;   // Đường dẫn ảnh
+    int shrink;         // Hệ số thu nhỏ khi đưa vào atlas
+    bool rotated;       // Quay 180 độ khi đưa vào atlas
+};
+
+// Packs a set of sprite images into one texture at load time so they can be
+// drawn through a RenderBatch without texture switches.
+class SpriteAtlas {
+private:
+    SDL_Texture* texture = nullptr;
+    int atlasW = 0;
+    int atlasH = 0;
+    SDL_Rect rects[static_cast<int>(Sprite::COUNT)] = {};
+
+public:
+    SpriteAtlas() = default;
+    ~SpriteAtlas();
+    SpriteAtlas(const SpriteAtlas&) = delete;
+    SpriteAtlas& operator=(const SpriteAtlas&) = delete;
+
+    // Loads, converts, shrinks and rotates one image. Safe to call from any thread.
+    static SDL_Surface* decode(const SpriteSource& source);
+
+    // Builds the collision masks from decoded PLAYER1, PLAYER2, PIPE and
+    // PIPE_FLIPPED surfaces, indexed by Sprite, at the size they are drawn.
+    // Does not take ownership.
+    static bool collisionMasks(SDL_Surface* const surfaces[], CollisionMasks& masks);
+
+    // Uploads surfaces[i] as sprites[i]. Takes ownership of the surfaces.
+    bool build(SDL_Renderer* renderer, const Sprite sprites[], SDL_Surface* const surfaces[], int count);
+    void destroy();
+    bool contains(Sprite sprite) const;
+    void draw(RenderBatch& batch, Sprite sprite, const SDL_FRect& dst) const;
+};
+
+#endif // SPRITEATLAS_H
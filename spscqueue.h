@@ -0,0 +1,41 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded single-producer, single-consumer queue. push() and pop() never
+// lock or allocate; push() fails when the queue is full.
+template <typename T, std::size_t CAPACITY>
+class SpscQueue {
+private:
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+    static constexpr std::size_t MASK = CAPACITY - 1;
+
+    T items[CAPACITY];
+    std::atomic<std::size_t> head{0};   // Next item to pop, owned by the consumer
+    std::atomic<std::size_t> tail{0};   // Next free slot, owned by the producer
+
+public:
+    bool push(const T& item) {
+        const std::size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == CAPACITY) return false;
+        items[t & MASK] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& item) {
+        const std::size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) return false;
+        item = items[h & MASK];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+};
+
+#endif // SPSCQUEUE_H
@@ -1,13 +1,12 @@
 #ifndef STRUCTS_H
 #define STRUCTS_H
 
-#include <SDL.h>
-#include <string>
-
 struct Pipe {
     int x;      // Tọa độ x của ống
     int gapY;   // Tọa độ y của khoảng trống giữa hai ống
-    Pipe(int x_, int gapY_) : x(x_), gapY(gapY_) {}
+    int prevX;  // Tọa độ x ở tick trước (dùng để nội suy khi vẽ)
+    Pipe() : x(0), gapY(0), prevX(0) {}
+    Pipe(int x_, int gapY_) : x(x_), gapY(gapY_), prevX(x_) {}
 };
 
 struct Bird {
@@ -15,28 +14,35 @@ struct Bird {
     float velocity;     // Vận tốc rơi/lên của chim
     bool alive = true;  // Trạng thái sống/chết của chim
     bool collided = false;  // Trạng thái va chạm với ống
-    bool dieSoundPlayed = false;  // Đánh dấu âm thanh chết đã phát chưa
+    bool dieSoundPlayed = false;  // Đánh dấu sự kiện chết đã được báo chưa
     int score = 0;      // Điểm số của chim
     explicit Bird(float y_) : y(y_), velocity(0) {}
 };
 
-struct Button {
-    SDL_Rect rect;      // Hình chữ nhật xác định vị trí và kích thước nút
-    std::string text;   // Văn bản hiển thị trên nút
-    int originalW, originalH;  // Kích thước gốc của nút
-    bool hovered = false;      // Trạng thái chuột đang hover trên nút
-    bool isRed = false;        // Màu sắc của nút (đỏ hoặc không)
-    Button(int x, int y, int w, int h, const std::string& t, bool red = false)
-        : rect{x, y, w, h}, text(t), originalW(w), originalH(h), isRed(red) {}
-};
-
 enum class GameState {
     MENU,               // Màn hình menu chính
     ONE_PLAYER,         // Chế độ 1 người chơi
     TWO_PLAYER,         // Chế độ 2 người chơi
     INFO,               // Màn hình thông tin
     TWO_PLAYER_WAITING, // Đợi bắt đầu chế độ 2 người
-    ONE_PLAYER_WAITING  // Đợi bắt đầu chế độ 1 người
+    ONE_PLAYER_WAITING, // Đợi bắt đầu chế độ 1 người
+    AI_BIRDS            // Quần thể chim AI tự bay và tiến hóa
+};
+
+enum class Sound {
+    DIE,        // Chim va ống rồi rơi xuống đất
+    HIT,        // Chim va vào ống
+    POINT,      // Chim vượt qua ống
+    WING,       // Chim vỗ cánh
+    CLICK,      // Bấm nút
+    FALLING,    // Chim rơi xuống đất mà không va ống
+    COUNT
+};
+
+enum class Music {
+    LOBBY,      // Nhạc ở menu
+    PLAYING,    // Nhạc khi đang chơi
+    COUNT
 };
 
 #endif // STRUCTS_H
@@ -0,0 +1,92 @@
+#include "telemetry.h"
+#include <cstring>
+
+bool TelemetryWriter::open(const char* name) {
+    close();
+    if (!memory.create(name, sizeof(TelemetryBlock))) return false;
+    block = static_cast<TelemetryBlock*>(memory.data());
+    block->version = TELEMETRY_VERSION;
+    block->slotCount = TELEMETRY_SLOTS;
+    block->frameSize = sizeof(TelemetryFrame);
+    block->published.store(0, std::memory_order_relaxed);
+    // Readers check the magic first, so it goes in last.
+    block->magic.store(TELEMETRY_MAGIC, std::memory_order_release);
+    next = 0;
+    return true;
+}
+
+void TelemetryWriter::close() {
+    if (block) block->magic.store(0, std::memory_order_release);
+    memory.close();
+    block = nullptr;
+}
+
+TelemetryFrame& TelemetryWriter::begin() {
+    TelemetrySlot& slot = block->slots[next % TELEMETRY_SLOTS];
+    slot.sequence.store(2 * next + 1, std::memory_order_relaxed);
+    // Orders the odd sequence before any write to the frame.
+    std::atomic_thread_fence(std::memory_order_release);
+    return slot.frame;
+}
+
+void TelemetryWriter::publish() {
+    TelemetrySlot& slot = block->slots[next % TELEMETRY_SLOTS];
+    slot.sequence.store(2 * next + 2, std::memory_order_release);
+    next++;
+    block->published.store(next, std::memory_order_release);
+}
+
+bool TelemetryReader::open(const char* name) {
+    close();
+    if (!memory.open(name, sizeof(TelemetryBlock))) return false;
+    block = static_cast<const TelemetryBlock*>(memory.data());
+    if (block->magic.load(std::memory_order_acquire) != TELEMETRY_MAGIC || block->version != TELEMETRY_VERSION ||
+        block->slotCount != TELEMETRY_SLOTS || block->frameSize != sizeof(TelemetryFrame)) {
+        close();
+        return false;
+    }
+    cursor = published();
+    return true;
+}
+
+void TelemetryReader::close() {
+    memory.close();
+    block = nullptr;
+}
+
+bool TelemetryReader::live() const {
+    return block->magic.load(std::memory_order_acquire) == TELEMETRY_MAGIC;
+}
+
+std::uint32_t TelemetryReader::published() const {
+    return block->published.load(std::memory_order_acquire);
+}
+
+bool TelemetryReader::read(std::uint32_t index, TelemetryFrame& frame) const {
+    const TelemetrySlot& slot = block->slots[index % TELEMETRY_SLOTS];
+    const std::uint32_t complete = 2 * index + 2;
+    if (slot.sequence.load(std::memory_order_acquire) != complete) return false;
+    std::memcpy(&frame, &slot.frame, sizeof(frame));
+    // Orders the copy before the second look at the sequence.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == complete;
+}
+
+bool TelemetryReader::latest(TelemetryFrame& frame) const {
+    const std::uint32_t count = published();
+    return count != 0 && read(count - 1, frame);
+}
+
+bool TelemetryReader::next(TelemetryFrame& frame, std::uint64_t& skipped) {
+    for (;;) {
+        const std::uint32_t count = published();
+        if (count == cursor) return false;
+        // Anything more than a ring behind has been overwritten already.
+        if (count - cursor > static_cast<std::uint32_t>(TELEMETRY_SLOTS)) {
+            skipped += count - cursor - TELEMETRY_SLOTS;
+            cursor = count - TELEMETRY_SLOTS;
+        }
+        if (read(cursor++, frame)) return true;
+        skipped++;
+    }
+}
@@ -0,0 +1,120 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include "constants.h"
+#include "sharedmemory.h"
+
+// Live game state published into shared memory for overlays and analytics.
+// The block is a header and a ring of frames, each guarded by a sequence
+// lock: the game never waits for a reader, and a reader that raced with the
+// writer sees a changed sequence and tries again. The layout is plain data
+// so readers in any language can map it; change TELEMETRY_VERSION with it.
+constexpr std::uint32_t TELEMETRY_MAGIC = 0x4d544246;  // "FBTM"
+constexpr std::uint32_t TELEMETRY_VERSION = 1;
+constexpr int TELEMETRY_SLOTS = 64;
+constexpr int TELEMETRY_BIRDS = 64;
+constexpr const char* TELEMETRY_DEFAULT_NAME = "flappy-telemetry";
+
+struct TelemetryBird {
+    float y;                // Tọa độ y
+    float velocity;         // Vận tốc
+    std::int32_t alive;     // 1 nếu còn sống
+    std::int32_t score;     // Điểm số
+};
+
+struct TelemetryPipe {
+    std::int32_t x;         // Tọa độ x
+    std::int32_t gapY;      // Tọa độ y của khoảng trống
+};
+
+struct TelemetryFrame {
+    std::uint64_t frame;            // Số thứ tự khung hình, từ 0
+    std::uint64_t publishedAt;      // Thời điểm công bố (ns, steady_clock)
+    std::int32_t gameState;         // GameState
+    std::uint32_t tick;             // Tick mô phỏng đang được vẽ
+    std::int32_t started;           // 1 nếu ván đã bắt đầu
+    std::int32_t over;              // 1 nếu ván đã kết thúc
+    std::int32_t winner;            // Người thắng, -1 nếu hòa hoặc chưa có
+    float frameMs;                  // Thời gian từ đầu khung hình trước tới đầu khung hình này
+    float workMs;                   // Thời gian xử lý khung hình này (input, mô phỏng, vẽ)
+    float publishUs;                // Thời gian ghi telemetry của khung hình trước
+    std::int32_t population;        // Tổng số chim trong ván (chế độ chim AI có thể nhiều hơn TELEMETRY_BIRDS)
+    std::int32_t populationAlive;   // Số chim còn bay
+    std::int32_t birdCount;         // Số phần tử hợp lệ trong birds
+    TelemetryBird birds[TELEMETRY_BIRDS];
+    std::int32_t pipeCount;         // Số phần tử hợp lệ trong pipes
+    TelemetryPipe pipes[Constants::PIPE_CAPACITY];
+};
+
+// Sequence is 2n + 1 while frame n is written into the slot and 2n + 2 once
+// it is complete, modulo 2^32. Counters are 32 bits so a read-only mapping
+// can load them atomically on 32-bit builds too.
+struct TelemetrySlot {
+    std::atomic<std::uint32_t> sequence;
+    TelemetryFrame frame;
+};
+
+struct TelemetryBlock {
+    std::atomic<std::uint32_t> magic;       // TELEMETRY_MAGIC once the block is ready
+    std::uint32_t version;
+    std::uint32_t slotCount;
+    std::uint32_t frameSize;
+    std::atomic<std::uint32_t> published;   // Frames published so far, modulo 2^32
+    TelemetrySlot slots[TELEMETRY_SLOTS];
+};
+
+static_assert(std::is_trivially_copyable<TelemetryFrame>::value && std::is_standard_layout<TelemetryFrame>::value,
+              "Telemetry frames are copied between processes");
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "Shared counters must not need a lock");
+
+// The game's side. Frames are written in place in the shared block, so
+// publishing costs one pass over the fields and two atomic stores.
+class TelemetryWriter {
+private:
+    SharedMemory memory;
+    TelemetryBlock* block = nullptr;
+    std::uint32_t next = 0;
+
+public:
+    bool open(const char* name);
+    void close();
+    bool opened() const { return block != nullptr; }
+
+    // Returns the slot for the next frame. Fill every field, then publish().
+    TelemetryFrame& begin();
+    void publish();
+};
+
+// The reader library: maps the block read-only and copies frames out.
+class TelemetryReader {
+private:
+    SharedMemory memory;
+    const TelemetryBlock* block = nullptr;
+    std::uint32_t cursor = 0;
+
+    bool read(std::uint32_t index, TelemetryFrame& frame) const;
+
+public:
+    // Fails if no game is publishing under name or its layout differs.
+    bool open(const char* name);
+    void close();
+    bool opened() const { return block != nullptr; }
+
+    // False once the game has closed the block; open() again to follow the
+    // next game.
+    bool live() const;
+    // Frames the writer has published so far, modulo 2^32.
+    std::uint32_t published() const;
+    // Copies the newest frame. Returns false if there is none yet or the
+    // writer overwrote it during the copy; trying again shortly will work.
+    bool latest(TelemetryFrame& frame) const;
+    // Copies the oldest frame not read yet. skipped counts the frames the
+    // writer overwrote before they could be read. Returns false if there is
+    // nothing new.
+    bool next(TelemetryFrame& frame, std::uint64_t& skipped);
+};
+
+#endif // TELEMETRY_H
@@ -0,0 +1,140 @@
+#include "textatlas.h"
+#include <algorithm>
+
+namespace {
+
+constexpr int ATLAS_WIDTH = 1024;
+constexpr int ATLAS_PADDING = 1;
+
+struct PendingGlyph {
+    SDL_Surface* surface;
+    SDL_Rect* target;
+};
+
+}
+
+GlyphAtlas::~GlyphAtlas() {
+    destroy();
+}
+
+bool GlyphAtlas::build(SDL_Renderer* renderer, TTF_Font* const fonts[], const SDL_Color colors[]) {
+    destroy();
+    const SDL_Color outlineColor = {0, 0, 0, 255};
+    std::vector<PendingGlyph> pending;
+    bool ok = true;
+
+    for (int s = 0; s < static_cast<int>(TextStyle::COUNT); s++) {
+        TTF_Font* font = fonts[s];
+        StyleGlyphs& style = styles[s];
+        style.height = TTF_FontHeight(font) + 2 * OUTLINE;
+
+        // The outline is black for every colour, so styles sharing a font share outlines.
+        int sharedOutline = -1;
+        for (int prev = 0; prev < s; prev++)
+            if (fonts[prev] == font) sharedOutline = prev;
+
+        for (int i = 0; i < GLYPH_COUNT; i++) {
+            const char text[2] = {static_cast<char>(FIRST_GLYPH + i), '\0'};
+            Glyph& glyph = style.glyphs[i];
+            TTF_SizeText(font, text, &glyph.advance, nullptr);
+
+            SDL_Surface* fill = TTF_RenderText_Blended(font, text, colors[s]);
+            if (fill) pending.push_back({fill, &glyph.fill});
+            else if (text[0] != ' ') ok = false;
+
+            if (sharedOutline >= 0) continue;
+            TTF_SetFontOutline(font, OUTLINE);
+            SDL_Surface* outline = TTF_RenderText_Blended(font, text, outlineColor);
+            TTF_SetFontOutline(font, 0);
+            if (outline) pending.push_back({outline, &glyph.outline});
+            else if (text[0] != ' ') ok = false;
+        }
+    }
+
+    // Shelf-pack the tallest glyphs first.
+    std::sort(pending.begin(), pending.end(), [](const PendingGlyph& a, const PendingGlyph& b) {
+        return a.surface->h > b.surface->h;
+    });
+    int penX = 0, penY = 0, shelfH = 0;
+    for (PendingGlyph& glyph : pending) {
+        const int w = glyph.surface->w, h = glyph.surface->h;
+        if (penX + w > ATLAS_WIDTH) {
+            penX = 0;
+            penY += shelfH + ATLAS_PADDING;
+            shelfH = 0;
+        }
+        *glyph.target = {penX, penY, w, h};
+        penX += w + ATLAS_PADDING;
+        shelfH = std::max(shelfH, h);
+    }
+    atlasW = ATLAS_WIDTH;
+    atlasH = 1;
+    while (atlasH < penY + shelfH) atlasH *= 2;
+
+    SDL_Surface* atlas = SDL_CreateRGBSurface(0, atlasW, atlasH, 32,
+        0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000);
+    if (atlas) {
+        for (PendingGlyph& glyph : pending) {
+            SDL_SetSurfaceBlendMode(glyph.surface, SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(glyph.surface, nullptr, atlas, glyph.target);
+        }
+        texture = SDL_CreateTextureFromSurface(renderer, atlas);
+        SDL_FreeSurface(atlas);
+    }
+    for (PendingGlyph& glyph : pending) SDL_FreeSurface(glyph.surface);
+    if (!texture) return false;
+    SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+
+    for (int s = 0; s < static_cast<int>(TextStyle::COUNT); s++) {
+        for (int prev = 0; prev < s; prev++) {
+            if (fonts[prev] != fonts[s]) continue;
+            for (int i = 0; i < GLYPH_COUNT; i++) styles[s].glyphs[i].outline = styles[prev].glyphs[i].outline;
+            break;
+        }
+    }
+    return ok;
+}
+
+void GlyphAtlas::destroy() {
+    SDL_DestroyTexture(texture);
+    texture = nullptr;
+}
+
+const GlyphAtlas::Glyph* GlyphAtlas::findGlyph(const StyleGlyphs& style, char c) const {
+    if (c < FIRST_GLYPH || c > LAST_GLYPH) return nullptr;
+    return &style.glyphs[c - FIRST_GLYPH];
+}
+
+void GlyphAtlas::measureText(TextStyle style, std::string_view text, int& w, int& h) const {
+    const StyleGlyphs& glyphs = styles[static_cast<int>(style)];
+    w = 2 * OUTLINE;
+    for (char c : text)
+        if (const Glyph* glyph = findGlyph(glyphs, c)) w += glyph->advance;
+    h = glyphs.height;
+}
+
+void GlyphAtlas::addQuad(RenderBatch& batch, const SDL_Rect& src, float x, float y) const {
+    if (src.w == 0 || src.h == 0) return;
+    batch.addQuad(texture, atlasW, atlasH, src, {x, y, static_cast<float>(src.w), static_cast<float>(src.h)});
+}
+
+void GlyphAtlas::drawText(RenderBatch& batch, TextStyle style, std::string_view text, int x, int y) const {
+    if (!texture) return;
+    const StyleGlyphs& glyphs = styles[static_cast<int>(style)];
+
+    // All outlines first so a glyph's outline never covers its neighbour's fill.
+    float penX = static_cast<float>(x);
+    for (char c : text) {
+        if (const Glyph* glyph = findGlyph(glyphs, c)) {
+            addQuad(batch, glyph->outline, penX, static_cast<float>(y));
+            penX += glyph->advance;
+        }
+    }
+    penX = static_cast<float>(x + OUTLINE);
+    for (char c : text) {
+        if (const Glyph* glyph = findGlyph(glyphs, c)) {
+            addQuad(batch, glyph->fill, penX, static_cast<float>(y + OUTLINE));
+            penX += glyph->advance;
+        }
+    }
+}
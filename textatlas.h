@@ -0,0 +1,62 @@
+#ifndef TEXTATLAS_H
+#define TEXTATLAS_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <string_view>
+#include "renderbatch.h"
+
+enum class TextStyle {
+    TITLE,      // Chữ lớn màu vàng (font)
+    SCORE,      // Chữ điểm số màu vàng (scoreFont)
+    INFO,       // Chữ thông tin màu vàng (infoFont)
+    INFO_RED,   // Chữ thông tin màu đỏ (infoFont)
+    HUD,        // Chữ nhỏ màu trắng của bảng profiler (hudFont)
+    COUNT
+};
+
+// Bakes the printable ASCII range of every TextStyle, outline and fill, into
+// one texture at startup. Strings are then drawn as textured quads with a
+// RenderBatch, so no font rasterization or texture upload happens while the
+// game runs.
+class GlyphAtlas {
+private:
+    static constexpr char FIRST_GLYPH = ' ';
+    static constexpr char LAST_GLYPH = '~';
+    static constexpr int GLYPH_COUNT = LAST_GLYPH - FIRST_GLYPH + 1;
+    static constexpr int OUTLINE = 2;
+
+    struct Glyph {
+        SDL_Rect outline{0, 0, 0, 0};   // Black outline, OUTLINE pixels larger on every side
+        SDL_Rect fill{0, 0, 0, 0};      // Coloured glyph drawn on top of the outline
+        int advance = 0;
+    };
+
+    struct StyleGlyphs {
+        Glyph glyphs[GLYPH_COUNT];
+        int height = 0;
+    };
+
+    SDL_Texture* texture = nullptr;
+    int atlasW = 0;
+    int atlasH = 0;
+    StyleGlyphs styles[static_cast<int>(TextStyle::COUNT)];
+
+    const Glyph* findGlyph(const StyleGlyphs& style, char c) const;
+    void addQuad(RenderBatch& batch, const SDL_Rect& src, float x, float y) const;
+
+public:
+    GlyphAtlas() = default;
+    ~GlyphAtlas();
+    GlyphAtlas(const GlyphAtlas&) = delete;
+    GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+    // fonts[i] is the font for TextStyle i. Fonts may be shared between styles.
+    bool build(SDL_Renderer* renderer, TTF_Font* const fonts[], const SDL_Color colors[]);
+    void destroy();
+
+    void measureText(TextStyle style, std::string_view text, int& w, int& h) const;
+    void drawText(RenderBatch& batch, TextStyle style, std::string_view text, int x, int y) const;
+};
+
+#endif // TEXTATLAS_H
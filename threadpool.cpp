@@ -0,0 +1,213 @@
+#include "threadpool.h"
+#include <algorithm>
+
+namespace {
+
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local int currentWorker = -1;
+
+constexpr std::uint64_t JOIN_OPEN = 1ull << 31;
+constexpr std::uint64_t JOIN_COUNT_MASK = JOIN_OPEN - 1;
+
+std::uint64_t packSlice(int begin, int end) {
+    return static_cast<std::uint64_t>(static_cast<std::uint32_t>(begin)) << 32 | static_cast<std::uint32_t>(end);
+}
+
+int sliceBegin(std::uint64_t slice) {
+    return static_cast<int>(slice >> 32);
+}
+
+int sliceEnd(std::uint64_t slice) {
+    return static_cast<int>(slice & 0xffffffffu);
+}
+
+}
+
+ThreadPool::ThreadPool(int threadCount) : workerCount(threadCount), slices(new std::atomic<std::uint64_t>[threadCount + 1]()) {
+    for (int i = 0; i <= threadCount; i++) slices[i].store(0, std::memory_order_relaxed);
+    for (int i = 0; i < threadCount; i++) queues.push_back(std::make_unique<WorkerQueue>());
+    for (int i = 0; i < threadCount; i++) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void ThreadPool::push(int queue, std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(queues[queue]->mutex);
+        queues[queue]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queued++;
+    }
+    taskAvailable.notify_one();
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    if (workerCount == 0) {
+        task();
+        return;
+    }
+    // A worker keeps the tasks it spawns on its own queue.
+    const int queue = currentPool == this ? currentWorker
+                    : static_cast<int>(nextQueue.fetch_add(1, std::memory_order_relaxed) % workerCount);
+    push(queue, std::move(task));
+}
+
+void ThreadPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return queued == 0 && busy == 0; });
+}
+
+int ThreadPool::size() const {
+    return workerCount;
+}
+
+bool ThreadPool::popTask(int index, std::function<void()>& task) {
+    // Own queue first, then the other queues starting with the next worker.
+    const int count = size();
+    for (int i = 0; i < count; i++) {
+        WorkerQueue& queue = *queues[(index + i) % count];
+        std::lock_guard<std::mutex> queueLock(queue.mutex);
+        if (queue.tasks.empty()) continue;
+        task = std::move(queue.tasks.front());
+        queue.tasks.pop_front();
+        std::lock_guard<std::mutex> lock(mutex);
+        queued--;
+        busy++;
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(int index) {
+    currentPool = this;
+    currentWorker = index;
+    std::function<void()> task;
+    std::uint32_t seenParallel = 0;
+    while (true) {
+        // A parallelFor call posted since the last look comes before queued tasks.
+        const std::uint32_t posted = parallelPosted.load(std::memory_order_acquire);
+        if (posted != seenParallel) {
+            seenParallel = posted;
+            helpParallel(posted, index);
+            continue;
+        }
+        if (popTask(index, task)) {
+            task();
+            task = nullptr;
+            std::lock_guard<std::mutex> lock(mutex);
+            busy--;
+            if (queued == 0 && busy == 0) idle.notify_all();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        taskAvailable.wait(lock, [this, seenParallel] {
+            return stopping || queued > 0 || parallelPosted.load(std::memory_order_relaxed) != seenParallel;
+        });
+        if (stopping && queued == 0) return;
+    }
+}
+
+void ThreadPool::parallelFor(int count, int grain, const std::function<void(int, int)>& body) {
+    if (count <= 0) return;
+    std::lock_guard<std::mutex> parallelLock(parallelMutex);
+    const int participants = size() + 1;
+    for (int i = 0; i < participants; i++) {
+        const int begin = static_cast<int>(static_cast<long long>(count) * i / participants);
+        const int end = static_cast<int>(static_cast<long long>(count) * (i + 1) / participants);
+        slices[i].store(packSlice(begin, end), std::memory_order_relaxed);
+    }
+    parallelBody = &body;
+    parallelGrain = std::max(grain, 1);
+    parallelRemaining.store(count, std::memory_order_relaxed);
+    const std::uint32_t generation = static_cast<std::uint32_t>(parallelJoin.load(std::memory_order_relaxed) >> 32) + 1;
+    parallelJoin.store(static_cast<std::uint64_t>(generation) << 32 | JOIN_OPEN, std::memory_order_release);
+
+    // Wakes every worker without queueing anything. Helpers that only look
+    // once the call has finished find it closed and return.
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        parallelPosted.store(generation, std::memory_order_release);
+    }
+    taskAvailable.notify_all();
+    runSlices(size());
+    while (parallelRemaining.load(std::memory_order_acquire) > 0) std::this_thread::yield();
+
+    // Close the call, then wait for helpers still looking for slices to steal.
+    parallelJoin.fetch_and(~JOIN_OPEN, std::memory_order_acq_rel);
+    while ((parallelJoin.load(std::memory_order_acquire) & JOIN_COUNT_MASK) != 0) std::this_thread::yield();
+}
+
+void ThreadPool::helpParallel(std::uint32_t generation, int slice) {
+    std::uint64_t join = parallelJoin.load(std::memory_order_acquire);
+    do {
+        if ((join >> 32) != generation || !(join & JOIN_OPEN)) return;
+    } while (!parallelJoin.compare_exchange_weak(join, join + 1, std::memory_order_acq_rel, std::memory_order_acquire));
+    runSlices(slice);
+    parallelJoin.fetch_sub(1, std::memory_order_release);
+}
+
+void ThreadPool::runSlices(int slice) {
+    const std::function<void(int, int)>& body = *parallelBody;
+    int begin, end;
+    do {
+        while (takeChunk(slice, begin, end)) {
+            body(begin, end);
+            parallelRemaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+        }
+    } while (stealInto(slice));
+}
+
+bool ThreadPool::takeChunk(int slice, int& begin, int& end) {
+    std::uint64_t packed = slices[slice].load(std::memory_order_acquire);
+    while (true) {
+        const int first = sliceBegin(packed);
+        const int last = sliceEnd(packed);
+        if (first >= last) return false;
+        const int taken = std::min(last, first + parallelGrain);
+        if (slices[slice].compare_exchange_weak(packed, packSlice(taken, last),
+                                                std::memory_order_acq_rel, std::memory_order_acquire)) {
+            begin = first;
+            end = taken;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::stealInto(int slice) {
+    // Indices are only ever consumed or handed on to a thief, never given back,
+    // so a slice never returns to a value read earlier and a successful
+    // compare-exchange cannot hand out indices twice.
+    const int participants = size() + 1;
+    while (true) {
+        int victim = -1;
+        int most = 0;
+        std::uint64_t victimSlice = 0;
+        for (int i = 0; i < participants; i++) {
+            if (i == slice) continue;
+            const std::uint64_t packed = slices[i].load(std::memory_order_acquire);
+            const int left = sliceEnd(packed) - sliceBegin(packed);
+            if (left > most) {
+                most = left;
+                victim = i;
+                victimSlice = packed;
+            }
+        }
+        if (victim < 0) return false;
+        const int first = sliceBegin(victimSlice);
+        const int last = sliceEnd(victimSlice);
+        const int middle = first + (last - first) / 2;
+        if (slices[victim].compare_exchange_strong(victimSlice, packSlice(first, middle), std::memory_order_acq_rel)) {
+            slices[slice].store(packSlice(middle, last), std::memory_order_release);
+            return true;
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads with one task queue each. A worker runs its own
+// queue in order and, when that is empty, steals the oldest task of another
+// worker. Tasks submitted from outside the pool are dealt round-robin.
+//
+// parallelFor() splits an index range into one slice per worker plus the
+// calling thread. Each takes small chunks off the front of its own slice and,
+// once that is empty, steals the back half of the largest remaining slice.
+class ThreadPool {
+private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // Fixed before any worker starts; workers read it while others are still being created.
+    const int workerCount;
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<unsigned> nextQueue{0};
+
+    // Guards sleeping and waitIdle(); queued and busy are only changed under it.
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable idle;
+    int queued = 0;
+    int busy = 0;
+    bool stopping = false;
+
+    // parallelFor state. Each slice packs [begin, end) as (begin << 32 | end).
+    std::mutex parallelMutex;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> slices;
+    const std::function<void(int, int)>* parallelBody = nullptr;
+    int parallelGrain = 1;
+    std::atomic<int> parallelRemaining{0};
+    // Generation of the latest call; changed under mutex so sleeping workers see it.
+    std::atomic<std::uint32_t> parallelPosted{0};
+    // Generation in the high 32 bits, an open flag in bit 31 and the number
+    // of helpers inside the current call below it.
+    std::atomic<std::uint64_t> parallelJoin{0};
+
+    void workerLoop(int index);
+    bool popTask(int index, std::function<void()>& task);
+    void push(int queue, std::function<void()> task);
+    void helpParallel(std::uint32_t generation, int slice);
+    void runSlices(int slice);
+    bool takeChunk(int slice, int& begin, int& end);
+    bool stealInto(int slice);
+
+public:
+    explicit ThreadPool(int threadCount);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // Blocks until every queue is empty and no task is running.
+    void waitIdle();
+    int size() const;
+
+    // Runs body(begin, end) over [0, count) in chunks of at most grain indices,
+    // on the workers and the calling thread. Returns once every index is done.
+    // Wakes the workers without queueing tasks, so it does not allocate
+    // unless body has to be wrapped into a std::function first. Concurrent
+    // calls run one after another.
+    void parallelFor(int count, int grain, const std::function<void(int, int)>& body);
+
+    template <typename F>
+    auto async(F function) -> std::future<decltype(function())> {
+        using Result = decltype(function());
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+        std::future<Result> result = task->get_future();
+        submit([task] { (*task)(); });
+        return result;
+    }
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,40 @@
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <cstdint>
+
+// Hands the latest value from one writer thread to one reader thread without
+// locks. The writer fills writeSlot() and publishes it; the reader swaps in
+// the newest published slot. Neither side ever waits for the other, and a
+// slow reader only skips values. The writer must rewrite the whole slot each
+// time, since the slot it gets back may hold any older value.
+template <typename T>
+class TripleBuffer {
+private:
+    static constexpr std::uint8_t INDEX_MASK = 3;
+    static constexpr std::uint8_t FRESH = 4;
+
+    T slots[3];
+    std::atomic<std::uint8_t> middle{1};
+    std::uint8_t back = 0;
+    std::uint8_t front = 2;
+
+public:
+    T& writeSlot() { return slots[back]; }
+
+    void publish() {
+        back = middle.exchange(static_cast<std::uint8_t>(back | FRESH), std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Returns true if a newer value was swapped in for read().
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+
+    const T& read() const { return slots[front]; }
+};
+
+#endif // TRIPLEBUFFER_H
@@ -0,0 +1,161 @@
+#include "udpsocket.h"
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+const SocketHandle NO_SOCKET = INVALID_SOCKET;
+
+// Winsock has to be started once per process before any other call.
+bool startNetworking() {
+    static const bool started = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return started;
+}
+
+void closeHandle(SocketHandle handle) {
+    closesocket(handle);
+}
+
+bool makeNonBlocking(SocketHandle handle) {
+    u_long enabled = 1;
+    return ioctlsocket(handle, FIONBIO, &enabled) == 0;
+}
+#else
+using SocketHandle = int;
+const SocketHandle NO_SOCKET = -1;
+
+bool startNetworking() {
+    return true;
+}
+
+void closeHandle(SocketHandle handle) {
+    ::close(handle);
+}
+
+bool makeNonBlocking(SocketHandle handle) {
+    const int flags = fcntl(handle, F_GETFL, 0);
+    return flags != -1 && fcntl(handle, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+#endif
+
+sockaddr_in toSockaddr(const NetAddress& address) {
+    sockaddr_in result;
+    std::memset(&result, 0, sizeof(result));
+    result.sin_family = AF_INET;
+    result.sin_addr.s_addr = htonl(address.host);
+    result.sin_port = htons(address.port);
+    return result;
+}
+
+}
+
+bool parseAddress(const char* text, NetAddress& address) {
+    const char* colon = std::strrchr(text, ':');
+    if (!colon || colon == text) return false;
+    const int port = std::atoi(colon + 1);
+    if (port <= 0 || port > 65535) return false;
+
+    char host[256];
+    const std::size_t length = static_cast<std::size_t>(colon - text);
+    if (length >= sizeof(host)) return false;
+    std::memcpy(host, text, length);
+    host[length] = '\0';
+    if (!startNetworking()) return false;
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) return false;
+    address.host = ntohl(reinterpret_cast<const sockaddr_in*>(found->ai_addr)->sin_addr.s_addr);
+    address.port = static_cast<std::uint16_t>(port);
+    freeaddrinfo(found);
+    return true;
+}
+
+UdpSocket::UdpSocket() : handle(NO_SOCKET) {}
+
+UdpSocket::~UdpSocket() {
+    close();
+}
+
+bool UdpSocket::open(std::uint16_t port) {
+    close();
+    if (!startNetworking()) return false;
+    const SocketHandle created = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (created == NO_SOCKET) return false;
+    const sockaddr_in local = toSockaddr({INADDR_ANY, port});
+    if (bind(created, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0 || !makeNonBlocking(created)) {
+        closeHandle(created);
+        return false;
+    }
+    handle = created;
+    isOpen = true;
+    return true;
+}
+
+void UdpSocket::close() {
+    if (!isOpen) return;
+    closeHandle(handle);
+    handle = NO_SOCKET;
+    isOpen = false;
+}
+
+std::uint16_t UdpSocket::getLocalPort() const {
+    if (!isOpen) return 0;
+    sockaddr_in local;
+    socklen_t size = sizeof(local);
+    if (getsockname(handle, reinterpret_cast<sockaddr*>(&local), &size) != 0) return 0;
+    return ntohs(local.sin_port);
+}
+
+bool UdpSocket::send(const NetAddress& to, const void* data, std::size_t size) {
+    if (!isOpen) return false;
+    const sockaddr_in target = toSockaddr(to);
+    return sendto(handle, static_cast<const char*>(data), static_cast<int>(size), 0,
+                  reinterpret_cast<const sockaddr*>(&target), sizeof(target)) == static_cast<int>(size);
+}
+
+std::size_t UdpSocket::receive(void* buffer, std::size_t capacity, NetAddress& from) {
+    if (!isOpen) return 0;
+    for (;;) {
+        sockaddr_in source;
+        socklen_t size = sizeof(source);
+        const int received = recvfrom(handle, static_cast<char*>(buffer), static_cast<int>(capacity), 0,
+                                      reinterpret_cast<sockaddr*>(&source), &size);
+        if (received < 0) {
+            // An oversized datagram, or the ICMP reply to an earlier send to a
+            // closed port, fails one read; anything else means nothing is waiting.
+#ifdef _WIN32
+            const int error = WSAGetLastError();
+            if (error == WSAEMSGSIZE || error == WSAECONNRESET) continue;
+#else
+            if (errno == EMSGSIZE || errno == ECONNREFUSED) continue;
+#endif
+            return 0;
+        }
+        if (received == 0) continue;
+        from.host = ntohl(source.sin_addr.s_addr);
+        from.port = ntohs(source.sin_port);
+        return static_cast<std::size_t>(received);
+    }
+}
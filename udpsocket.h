@@ -0,0 +1,50 @@
+#ifndef UDPSOCKET_H
+#define UDPSOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+
+// An IPv4 address and port, both in host byte order.
+struct NetAddress {
+    std::uint32_t host = 0;     // Địa chỉ IPv4
+    std::uint16_t port = 0;     // Cổng UDP, 0 nếu chưa biết
+
+    bool operator==(const NetAddress& other) const { return host == other.host && port == other.port; }
+    bool operator!=(const NetAddress& other) const { return !(*this == other); }
+};
+
+// Parses "host:port". The host may be a dotted address or a name to look up.
+bool parseAddress(const char* text, NetAddress& address);
+
+// Non-blocking UDP socket. Sending and receiving never wait and never
+// allocate, so both are safe to call from the simulation thread every tick.
+class UdpSocket {
+private:
+#ifdef _WIN32
+    std::uintptr_t handle;
+#else
+    int handle;
+#endif
+    bool isOpen = false;
+
+public:
+    UdpSocket();
+    ~UdpSocket();
+    UdpSocket(const UdpSocket&) = delete;
+    UdpSocket& operator=(const UdpSocket&) = delete;
+
+    // Binds to port on every interface; port 0 picks a free one.
+    bool open(std::uint16_t port);
+    void close();
+    bool opened() const { return isOpen; }
+    // The port actually bound, or 0 if the socket is closed.
+    std::uint16_t getLocalPort() const;
+
+    bool send(const NetAddress& to, const void* data, std::size_t size);
+    // Returns the size of the datagram read into buffer, or 0 if none is
+    // waiting. A datagram larger than capacity is cut short or skipped,
+    // depending on the platform.
+    std::size_t receive(void* buffer, std::size_t capacity, NetAddress& from);
+};
+
+#endif // UDPSOCKET_H
@@ -0,0 +1,93 @@
+#include "vecenv.h"
+#include <algorithm>
+
+namespace {
+
+// Splitmix64 finaliser: consecutive games of a world get unrelated pipe layouts.
+std::uint32_t episodeSeed(std::uint32_t worldSeed, std::uint32_t episode) {
+    std::uint64_t z = (static_cast<std::uint64_t>(worldSeed) << 32 | episode) + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return static_cast<std::uint32_t>(z ^ (z >> 31));
+}
+
+}
+
+VecEnv::VecEnv(int worldCount, int playersPerWorld, int threads)
+    : worldCount(worldCount), players(playersPerWorld), pool(std::max(threads, 1) - 1),
+      worlds(worldCount), seeds(worldCount), episodes(worldCount),
+      observations(static_cast<std::size_t>(worldCount) * playersPerWorld * OBSERVATION_SIZE),
+      rewards(static_cast<std::size_t>(worldCount) * playersPerWorld), dones(worldCount),
+      finalScores(static_cast<std::size_t>(worldCount) * playersPerWorld) {
+    // Several chunks per thread leave room for stealing when some worlds run slower.
+    grain = std::max(1, worldCount / (std::max(threads, 1) * 8));
+    stepRange = [this](int begin, int end) {
+        for (int world = begin; world < end; world++) stepWorld(world);
+    };
+}
+
+void VecEnv::reset(const std::uint32_t* worldSeeds) {
+    std::copy(worldSeeds, worldSeeds + worldCount, seeds.begin());
+    std::fill(episodes.begin(), episodes.end(), 0);
+    std::fill(rewards.begin(), rewards.end(), 0.0f);
+    std::fill(dones.begin(), dones.end(), 0);
+    std::fill(finalScores.begin(), finalScores.end(), 0);
+    pool.parallelFor(worldCount, grain, [this](int begin, int end) {
+        for (int world = begin; world < end; world++) {
+            startWorld(world);
+            observe(world);
+        }
+    });
+}
+
+void VecEnv::step(const std::uint8_t* agentActions) {
+    actions = agentActions;
+    pool.parallelFor(worldCount, grain, stepRange);
+    actions = nullptr;
+}
+
+void VecEnv::startWorld(int world) {
+    Simulation& simulation = worlds[world];
+    simulation.seed(episodeSeed(seeds[world], episodes[world]));
+    simulation.reset(players);
+    simulation.start();
+}
+
+void VecEnv::stepWorld(int world) {
+    Simulation& simulation = worlds[world];
+    const int first = world * players;
+    for (int bird = 0; bird < players; bird++)
+        if (actions[first + bird]) simulation.flap(bird);
+    simulation.step();
+
+    const BirdPopulation& birds = simulation.getBirds();
+    float* reward = &rewards[first];
+    for (int bird = 0; bird < players; bird++)
+        reward[bird] = birds.isAlive(bird) && !birds.isCollided(bird) ? ALIVE_REWARD : 0.0f;
+    // A bird that hit a pipe lands with DIE, so it is only penalised once.
+    for (const SimEvent& event : simulation.getEvents()) {
+        if (event.type == SimEventType::POINT) reward[event.bird] += POINT_REWARD;
+        else if (event.type == SimEventType::HIT || event.type == SimEventType::FALL) reward[event.bird] += DEATH_REWARD;
+    }
+    simulation.clearEvents();
+
+    dones[world] = simulation.isOver() ? 1 : 0;
+    if (dones[world]) {
+        std::copy(birds.getScore(), birds.getScore() + players, &finalScores[first]);
+        episodes[world]++;
+        startWorld(world);
+    }
+    observe(world);
+}
+
+void VecEnv::observe(int world) {
+    const Simulation& simulation = worlds[world];
+    for (int bird = 0; bird < players; bird++) {
+        const BirdObservation seen = simulation.observe(bird, simulation.nextPipe(simulation.getBirdX(bird)));
+        float* observation = &observations[static_cast<std::size_t>(world * players + bird) * OBSERVATION_SIZE];
+        observation[0] = seen.y;
+        observation[1] = seen.velocity;
+        observation[2] = seen.pipeDistance;
+        observation[3] = seen.gapOffset;
+    }
+}
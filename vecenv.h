@@ -0,0 +1,62 @@
+#ifndef VECENV_H
+#define VECENV_H
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "simulation.h"
+#include "threadpool.h"
+
+// Many independent game worlds stepped together, for training agents without
+// a window. Every world is its own seeded Simulation, so results depend only
+// on the seeds and actions, not on the number of threads.
+//
+// Buffers are flat arrays indexed by agent (world * players + bird). A world
+// whose game ends is reported in getDones() and immediately reset with its
+// next seed; the observation returned for it is the first of the new game.
+class VecEnv {
+public:
+    // y, velocity, distance to the end of the next pipe and offset from the
+    // centre of its gap, all scaled to roughly [-1, 1].
+    static constexpr int OBSERVATION_SIZE = 4;
+    static constexpr float ALIVE_REWARD = 0.1f;    // Per tick a bird flies without having hit anything
+    static constexpr float POINT_REWARD = 1.0f;    // Per pipe passed
+    static constexpr float DEATH_REWARD = -1.0f;   // Once, on hitting a pipe or the ground
+
+private:
+    int worldCount;
+    int players;
+    ThreadPool pool;
+    std::vector<Simulation> worlds;
+    std::vector<std::uint32_t> seeds;       // Seed given to reset() for each world
+    std::vector<std::uint32_t> episodes;    // Games finished per world
+    std::vector<float> observations;
+    std::vector<float> rewards;
+    std::vector<std::uint8_t> dones;
+    std::vector<std::int32_t> finalScores;  // Scores of each world's last finished game
+    const std::uint8_t* actions = nullptr;
+    int grain = 1;                          // Worlds per parallelFor chunk
+    std::function<void(int, int)> stepRange;
+
+    void startWorld(int world);
+    void stepWorld(int world);
+    void observe(int world);
+
+public:
+    // threads counts the calling thread, so 1 runs everything inline.
+    VecEnv(int worldCount, int playersPerWorld, int threads);
+
+    // One seed per world.
+    void reset(const std::uint32_t* worldSeeds);
+    // One action per agent; nonzero flaps.
+    void step(const std::uint8_t* agentActions);
+
+    int getWorldCount() const { return worldCount; }
+    int getAgentCount() const { return worldCount * players; }
+    const float* getObservations() const { return observations.data(); }
+    const float* getRewards() const { return rewards.data(); }
+    const std::uint8_t* getDones() const { return dones.data(); }
+    const std::int32_t* getFinalScores() const { return finalScores.data(); }
+};
+
+#endif // VECENV_H
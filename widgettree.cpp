@@ -0,0 +1,124 @@
+#include "widgettree.h"
+#include <algorithm>
+
+namespace {
+
+bool containsPoint(const SDL_Rect& rect, int x, int y) {
+    return x >= rect.x && x <= rect.x + rect.w && y >= rect.y && y <= rect.y + rect.h;
+}
+
+}
+
+void HitGrid::clear() {
+    for (Cell& cell : cells) cell.count = 0;
+}
+
+bool HitGrid::insert(int item, const SDL_Rect& rect) {
+    // Edges are inclusive, matching containsPoint.
+    const int firstColumn = std::clamp(rect.x / CELL_SIZE, 0, COLUMNS - 1);
+    const int lastColumn = std::clamp((rect.x + rect.w) / CELL_SIZE, 0, COLUMNS - 1);
+    const int firstRow = std::clamp(rect.y / CELL_SIZE, 0, ROWS - 1);
+    const int lastRow = std::clamp((rect.y + rect.h) / CELL_SIZE, 0, ROWS - 1);
+    bool ok = true;
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int column = firstColumn; column <= lastColumn; column++) {
+            Cell& cell = cells[row * COLUMNS + column];
+            if (cell.count == MAX_PER_CELL) {
+                ok = false;
+                continue;
+            }
+            cell.items[cell.count++] = static_cast<std::uint8_t>(item);
+        }
+    }
+    return ok;
+}
+
+int HitGrid::find(int x, int y, const std::vector<SDL_Rect>& rects) const {
+    if (x < 0 || y < 0 || x >= COLUMNS * CELL_SIZE || y >= ROWS * CELL_SIZE) return -1;
+    const Cell& cell = cells[(y / CELL_SIZE) * COLUMNS + x / CELL_SIZE];
+    for (int i = 0; i < cell.count; i++)
+        if (containsPoint(rects[cell.items[i]], x, y)) return cell.items[i];
+    return -1;
+}
+
+WidgetTree::ScreenWidgets& WidgetTree::current() {
+    return screens[static_cast<int>(active)];
+}
+
+const WidgetTree::ScreenWidgets& WidgetTree::current() const {
+    return screens[static_cast<int>(active)];
+}
+
+void WidgetTree::add(UiScreen screen, const Button& button) {
+    ScreenWidgets& widgets = screens[static_cast<int>(screen)];
+    widgets.buttons.push_back(button);
+    widgets.hoverRects.push_back(button.hoverRect);
+    widgets.clickRects.push_back(button.rect);
+}
+
+bool WidgetTree::finishLayout() {
+    bool ok = true;
+    for (ScreenWidgets& widgets : screens) {
+        widgets.hoverGrid.clear();
+        widgets.clickGrid.clear();
+        for (int i = 0; i < static_cast<int>(widgets.buttons.size()); i++) {
+            ok = widgets.hoverGrid.insert(i, widgets.hoverRects[i]) && ok;
+            ok = widgets.clickGrid.insert(i, widgets.clickRects[i]) && ok;
+        }
+    }
+    return ok;
+}
+
+void WidgetTree::setHovered(Button& button, bool value) {
+    button.hovered = value;
+    if (value) {
+        button.rect.w = static_cast<int>(button.originalW * button.hoverScale);
+        button.rect.h = static_cast<int>(button.originalH * button.hoverScale);
+        button.rect.x -= (button.rect.w - button.originalW) / 2;
+        button.rect.y -= (button.rect.h - button.originalH) / 2;
+    } else {
+        button.rect.w = button.originalW;
+        button.rect.h = button.originalH;
+        button.rect.x += (static_cast<int>(button.originalW * button.hoverScale) - button.originalW) / 2;
+        button.rect.y += (static_cast<int>(button.originalH * button.hoverScale) - button.originalH) / 2;
+    }
+}
+
+void WidgetTree::setScreen(UiScreen screen) {
+    // A screen is shown again the way it was laid out, with nothing hovered.
+    if (hovered >= 0) setHovered(current().buttons[hovered], false);
+    hovered = -1;
+    active = screen;
+}
+
+UiScreen WidgetTree::getScreen() const {
+    return active;
+}
+
+bool WidgetTree::hover(int x, int y) {
+    ScreenWidgets& widgets = current();
+    const int target = widgets.hoverGrid.find(x, y, widgets.hoverRects);
+    if (target == hovered) return false;
+    if (hovered >= 0) setHovered(widgets.buttons[hovered], false);
+    if (target >= 0) setHovered(widgets.buttons[target], true);
+    hovered = target;
+    return true;
+}
+
+const Button* WidgetTree::click(int x, int y) const {
+    const ScreenWidgets& widgets = current();
+    const int target = widgets.clickGrid.find(x, y, widgets.clickRects);
+    if (target >= 0) return &widgets.buttons[target];
+    if (hovered >= 0 && containsPoint(widgets.buttons[hovered].rect, x, y)) return &widgets.buttons[hovered];
+    return nullptr;
+}
+
+const Button* WidgetTree::find(ButtonAction action) const {
+    for (const Button& button : current().buttons)
+        if (button.action == action) return &button;
+    return nullptr;
+}
+
+const std::vector<Button>& WidgetTree::getButtons() const {
+    return current().buttons;
+}
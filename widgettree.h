@@ -0,0 +1,79 @@
+#ifndef WIDGETTREE_H
+#define WIDGETTREE_H
+
+#include <SDL.h>
+#include <cstdint>
+#include <vector>
+#include "button.h"
+#include "constants.h"
+
+enum class UiScreen {
+    NONE,           // Đang chơi, không có nút
+    MENU,           // Menu chính
+    INFO,           // Màn hình thông tin
+    RETURN_TO_MENU, // Màn hình chờ và kết thúc ván, chỉ có nút về menu
+    COUNT
+};
+
+// Buckets widget rectangles into fixed window cells so a point lookup only
+// tests the few widgets in one cell. Items are returned in insertion order.
+class HitGrid {
+private:
+    static constexpr int CELL_SIZE = 64;
+    static constexpr int COLUMNS = (Constants::WINDOW_WIDTH + CELL_SIZE - 1) / CELL_SIZE;
+    static constexpr int ROWS = (Constants::WINDOW_HEIGHT + CELL_SIZE - 1) / CELL_SIZE;
+    static constexpr int MAX_PER_CELL = 4;
+
+    struct Cell {
+        std::uint8_t count = 0;
+        std::uint8_t items[MAX_PER_CELL] = {};
+    };
+
+    Cell cells[COLUMNS * ROWS];
+
+public:
+    void clear();
+    // Returns false if a cell the rectangle touches is already full.
+    bool insert(int item, const SDL_Rect& rect);
+    // First item whose rects[item] contains the point, or -1.
+    int find(int x, int y, const std::vector<SDL_Rect>& rects) const;
+};
+
+// Every screen's buttons, laid out once at startup. Switching screens only
+// changes which set is active; hover and click lookups go through a HitGrid.
+class WidgetTree {
+private:
+    struct ScreenWidgets {
+        std::vector<Button> buttons;
+        std::vector<SDL_Rect> hoverRects;
+        std::vector<SDL_Rect> clickRects;
+        HitGrid hoverGrid;
+        HitGrid clickGrid;
+    };
+
+    ScreenWidgets screens[static_cast<int>(UiScreen::COUNT)];
+    UiScreen active = UiScreen::NONE;
+    int hovered = -1;
+
+    ScreenWidgets& current();
+    const ScreenWidgets& current() const;
+    void setHovered(Button& button, bool value);
+
+public:
+    // The button's hoverRect and text extents must already be measured.
+    void add(UiScreen screen, const Button& button);
+    // Builds the hit grids. Call once after every button has been added.
+    bool finishLayout();
+
+    void setScreen(UiScreen screen);
+    UiScreen getScreen() const;
+
+    // Updates hover state for a pointer position. Returns true if it changed.
+    bool hover(int x, int y);
+    // The hovered button uses its enlarged rect; others their laid-out rect.
+    const Button* click(int x, int y) const;
+    const Button* find(ButtonAction action) const;
+    const std::vector<Button>& getButtons() const;
+};
+
+#endif // WIDGETTREE_H